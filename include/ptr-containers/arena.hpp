@@ -0,0 +1,175 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace ut {
+
+/** A region of memory which objects are bump-allocated out of.
+ *
+ * Memory is requested from the system in chunks of (at least) `chunk_size`
+ * bytes. Individual allocations are never freed, all of the memory is
+ * returned at once by `release()` or when the arena is destroyed.
+ */
+class Arena {
+    struct Chunk {
+        Chunk *prev;
+        std::size_t size;
+    };
+
+    Chunk *m_chunks = nullptr;
+    std::byte *m_cur = nullptr;
+    std::byte *m_end = nullptr;
+    std::size_t m_chunk_size;
+
+public:
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    explicit Arena(std::size_t chunk_size = default_chunk_size)
+            : m_chunk_size(chunk_size) { }
+
+    Arena(Arena const &) = delete;
+    Arena &operator=(Arena const &) = delete;
+
+    ~Arena() {
+        release();
+    }
+
+    [[nodiscard]]
+    void *allocate(std::size_t bytes, std::size_t align) {
+        auto *ptr = alignUp(m_cur, align);
+        if (!m_cur || ptr > m_end || bytes > std::size_t(m_end - ptr))  //
+            ptr = alignUp(newChunk(bytes + align), align);
+        m_cur = ptr + bytes;
+        return ptr;
+    }
+
+    /** Make sure the next `bytes` bytes of allocations (including any padding
+     *  needed for alignment) are served from a single chunk.
+     */
+    void reserve(std::size_t bytes) {
+        if (!m_cur || bytes > std::size_t(m_end - m_cur)) newChunk(bytes);
+    }
+
+    /// Free all of the memory owned by the arena
+    void release() noexcept {
+        while (m_chunks) {
+            auto *prev = m_chunks->prev;
+            ::operator delete(m_chunks, m_chunks->size);
+            m_chunks = prev;
+        }
+        m_cur = nullptr;
+        m_end = nullptr;
+    }
+
+    /// Total number of bytes requested from the system (including bookkeeping)
+    std::size_t reserved_bytes() const {
+        std::size_t total = 0;
+        for (auto *chunk = m_chunks; chunk; chunk = chunk->prev)
+            total += chunk->size;
+        return total;
+    }
+
+    std::size_t chunk_size() const {
+        return m_chunk_size;
+    }
+
+private:
+    static std::byte *alignUp(std::byte *ptr, std::size_t align) {
+        auto const addr = reinterpret_cast<std::uintptr_t>(ptr);
+        return ptr + ((align - addr % align) % align);
+    }
+
+    std::byte *newChunk(std::size_t min_bytes) {
+        auto const size = std::max(m_chunk_size, sizeof(Chunk) + min_bytes);
+        auto *chunk = static_cast<Chunk *>(::operator new(size));
+        chunk->prev = m_chunks;
+        chunk->size = size;
+        m_chunks = chunk;
+        m_cur = reinterpret_cast<std::byte *>(chunk + 1);
+        m_end = reinterpret_cast<std::byte *>(chunk) + size;
+        return m_cur;
+    }
+};
+
+/** An allocator handing out memory from a shared `Arena`.
+ *
+ * A default constructed allocator creates a new arena, copies (including
+ * rebound ones) share it. The arena is destroyed with the last allocator
+ * referring to it.
+ *
+ * `deallocate` is a no-op, memory is only reclaimed by `try_release()`, which
+ * frees the whole region if this allocator is the only one referring to it.
+ * `OwnPtrVec` uses this to drop all of its elements in one step when none of
+ * them need destroying (see `ArenaPtrVec`).
+ */
+template<typename T>
+class ArenaAllocator {
+    template<typename U>
+    friend class ArenaAllocator;
+
+    std::shared_ptr<Arena> m_arena;
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator()
+            : m_arena(std::make_shared<Arena>()) { }
+
+    explicit ArenaAllocator(std::size_t chunk_size)
+            : m_arena(std::make_shared<Arena>(chunk_size)) { }
+
+    // NOTE: Moving an allocator must not change the source, so there are no move operations
+    ArenaAllocator(ArenaAllocator const &) = default;
+    ArenaAllocator &operator=(ArenaAllocator const &) = default;
+
+    template<typename U>
+    ArenaAllocator(ArenaAllocator<U> const &other)
+            : m_arena(other.m_arena) { }
+
+    [[nodiscard]]
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, std::size_t) noexcept { }
+
+    [[nodiscard]]
+    void *allocate_bytes(std::size_t bytes, std::size_t align) {
+        return m_arena->allocate(bytes, align);
+    }
+
+    void deallocate_bytes(void *, std::size_t, std::size_t) noexcept { }
+
+    /** Free the whole region if no other allocator refers to it.
+     *
+     * Returns whether the memory was released. Any memory allocated from
+     * the region becomes invalid if it was.
+     */
+    bool try_release() noexcept {
+        if (m_arena.use_count() != 1) return false;
+        m_arena->release();
+        return true;
+    }
+
+    Arena &arena() const {
+        return *m_arena;
+    }
+
+    template<typename U>
+    bool operator==(ArenaAllocator<U> const &other) const {
+        return m_arena == other.m_arena;
+    }
+};
+
+}  // namespace ut
+
+#endif  // ARENA_HPP
@@ -0,0 +1,343 @@
+#ifndef CONCATPTRVECVIEW_HPP
+#define CONCATPTRVECVIEW_HPP
+
+#include "ptrvecview.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <vector>
+
+namespace ut {
+
+/** A light-weight, non-owning view of several containers of pointers to `T`
+ *  (such as `OwnPtrVec`s or `PtrVecView`s) as one sequence, without copying
+ *  their pointers.
+ *
+ * Indexing finds the segment with a binary search over the segment offsets,
+ * while iterating steps through each segment directly. `for_each` visits one
+ * segment at a time.
+ *
+ * Like `PtrVecView`, the view is invalidated by anything that invalidates
+ * the views of its segments.
+ *
+ * Iterators refer to the view's list of segments rather than to the view
+ * itself, so they stay valid when the view is moved, but not once it is
+ * destroyed or appended to. (Hence `begin` and `end` cannot be called on a
+ * temporary view.)
+ */
+template<typename T>
+class ConcatPtrVecView {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T const *;
+    using const_reference = T const *;
+
+private:
+    /// Non-empty segments
+    std::vector<PtrVecView<T>> m_segments;
+    /// Index of the first element of each segment, followed by the total size
+    std::vector<size_type> m_offsets {0};
+
+    /// Another `ConcatPtrVecView`, or a container (or view) of pointers to `T`
+    template<typename C>
+    static constexpr bool comparable_with = std::same_as<C, ConcatPtrVecView>
+        || (InheritsContainerBase<C> && requires(C const &c) { PtrVecView<T>(c.begin(), c.size()); });
+
+public:
+    class const_iterator {
+        PtrVecView<T> const *m_segments = nullptr;
+        size_type const *m_offsets = nullptr;
+        size_type m_seg_count = 0;
+        size_type m_seg = 0;
+        size_type m_pos = 0;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T const *;
+        using difference_type = std::ptrdiff_t;
+        using reference = T const *;
+        using pointer = void;
+
+        const_iterator() = default;
+
+        const_iterator(ConcatPtrVecView const &view, size_type seg, size_type pos)
+                : m_segments(view.m_segments.data())
+                , m_offsets(view.m_offsets.data())
+                , m_seg_count(view.m_segments.size())
+                , m_seg(seg)
+                , m_pos(pos) { }
+
+        reference operator*() const {
+            return m_segments[m_seg][m_pos];
+        }
+
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+
+        const_iterator &operator++() {
+            if (++m_pos == m_segments[m_seg].size()) {
+                ++m_seg;
+                m_pos = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        const_iterator &operator--() {
+            if (m_pos == 0)
+                m_pos = m_segments[--m_seg].size();
+            --m_pos;
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            auto tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        const_iterator &operator+=(difference_type n) {
+            auto const idx = size_type(difference_type(index()) + n);
+            assert(idx <= m_offsets[m_seg_count]);
+            m_seg = segmentOf(m_offsets, m_seg_count, idx);
+            m_pos = idx - m_offsets[m_seg];
+            return *this;
+        }
+
+        const_iterator &operator-=(difference_type n) {
+            return *this += -n;
+        }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend const_iterator operator+(difference_type n, const_iterator it) {
+            return it += n;
+        }
+
+        friend const_iterator operator-(const_iterator it, difference_type n) {
+            return it -= n;
+        }
+
+        friend difference_type operator-(const_iterator const &a, const_iterator const &b) {
+            return difference_type(a.index()) - difference_type(b.index());
+        }
+
+        friend bool operator==(const_iterator const &a, const_iterator const &b) {
+            return a.m_seg == b.m_seg && a.m_pos == b.m_pos;
+        }
+
+        friend std::strong_ordering operator<=>(const_iterator const &a, const_iterator const &b) {
+            if (auto cmp = a.m_seg <=> b.m_seg; cmp != 0) return cmp;
+            return a.m_pos <=> b.m_pos;
+        }
+
+    private:
+        size_type index() const {
+            return m_offsets[m_seg] + m_pos;
+        }
+    };
+
+    using iterator = const_iterator;
+
+    ConcatPtrVecView() = default;
+
+    ConcatPtrVecView(std::initializer_list<PtrVecView<T>> segments) {
+        m_segments.reserve(segments.size());
+        for (auto const &seg : segments)
+            append(seg);
+    }
+
+    /// View the elements of each container in `containers`, one after another
+    template<std::ranges::input_range R>
+    explicit ConcatPtrVecView(R const &containers)
+        requires requires(ConcatPtrVecView &v, std::ranges::range_reference_t<R const> c) { v.append(c); }
+    {
+        if constexpr (std::ranges::sized_range<R>) m_segments.reserve(std::ranges::size(containers));
+        for (auto const &c : containers)
+            append(c);
+    }
+
+    /// Add the elements of `seg` to the end of the view
+    void append(PtrVecView<T> seg) {
+        if (seg.empty()) return;
+        m_offsets.push_back(m_offsets.back() + seg.size());
+        m_segments.push_back(seg);
+    }
+
+    /// Add the elements of `container` (an `OwnPtrVec` or similar) to the end of the view
+    template<typename C>
+    void append(C const &container) requires requires { PtrVecView<T>(container.begin(), container.size()); } {
+        append(PtrVecView<T>(container.begin(), container.size()));
+    }
+
+    T const *operator[](size_type idx) const {
+        assert(idx < size());
+        auto const seg = segmentOf(m_offsets.data(), m_segments.size(), idx);
+        return m_segments[seg][idx - m_offsets[seg]];
+    }
+
+    T const *front() const {
+        assert(!empty());
+        return m_segments.front().front();
+    }
+
+    T const *back() const {
+        assert(!empty());
+        return m_segments.back().back();
+    }
+
+    size_type size() const {
+        return m_offsets.back();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    const_iterator begin() const & {
+        return const_iterator(*this, 0, 0);
+    }
+
+    const_iterator end() const & {
+        return const_iterator(*this, m_segments.size(), 0);
+    }
+
+    const_iterator begin() const && = delete;
+    const_iterator end() const && = delete;
+
+    /// The (non-empty) segments making up the view
+    std::vector<PtrVecView<T>> const &segments() const {
+        return m_segments;
+    }
+
+    /// Call `f` on every element, one segment at a time
+    template<typename F>
+    void for_each(F &&f) const {
+        for (auto const &seg : m_segments)
+            for (auto const *ptr : seg)
+                f(*ptr);
+    }
+
+    /// See `ContainerBase::for_each_prefetched`, prefetching within each segment
+    template<typename F>
+    void for_each_prefetched(F &&f, size_type distance = default_prefetch_distance) const {
+        for (auto const &seg : m_segments)
+            detail::forEachPrefetched(seg.data(), seg.size(), distance, f);
+    }
+
+    /// See `ContainerBase::for_each_as`, the elements are grouped within each segment
+    template<typename... Ds, typename F>
+    void for_each_as(F &&f) const {
+        for (auto const &seg : m_segments)
+            detail::forEachAs<Ds...>(seg.data(), seg.size(), f);
+    }
+
+    /** Compares the elements (not the pointers) with another `ConcatPtrVecView`
+     *  or a container such as `OwnPtrVec`, like the containers compare among
+     *  themselves.
+     */
+    template<typename C>
+    friend bool operator==(ConcatPtrVecView const &a, C const &b) requires comparable_with<C> {
+        if (a.size() != b.size()) return false;
+        PtrVecView<T> whole;
+        return !zipSegments(a.m_segments, segmentsOf(b, whole), [](auto const *x, auto const *y, size_type n) {
+            auto differ = [x, y](std::size_t i) { return *x[i] != *y[i]; };
+            return detail::scanDifferingPointers(x, y, 0, n, differ);
+        });
+    }
+
+    /// Lexicographically compares the elements (not the pointers), see `operator==`
+    template<typename C>
+    friend auto operator<=>(ConcatPtrVecView const &a, C const &b)
+        -> detail::SynthThreeWayResult<typename C::value_type>
+        requires comparable_with<C>
+    {
+        detail::SynthThreeWayResult<T> result = std::strong_ordering::equal;
+        PtrVecView<T> whole;
+        auto differ = zipSegments(a.m_segments, segmentsOf(b, whole), [&](auto const *x, auto const *y, size_type n) {
+            auto order = [&](std::size_t i) {
+                result = detail::synthThreeWay<T>(*x[i], *y[i]);
+                return result != 0;
+            };
+            return detail::scanDifferingPointers(x, y, 0, n, order);
+        });
+        if (differ) return result;
+        return a.size() <=> b.size();
+    }
+
+private:
+    /// The segments of `c`, or (for a container) all of it as one segment stored in `whole`
+    template<typename C>
+    static std::span<PtrVecView<T> const> segmentsOf(C const &c, PtrVecView<T> &whole) {
+        if constexpr (std::same_as<C, ConcatPtrVecView>)
+            return c.m_segments;
+        else {
+            whole = PtrVecView<T>(c.begin(), c.size());
+            return {&whole, 1};
+        }
+    }
+
+    /** Call `f(x, y, n)` for each run of `n` pointers which is contiguous in
+     *  both `a` and `b`, up to the end of the shorter one, until it returns true.
+     *
+     * Returns whether `f` stopped the walk.
+     */
+    template<typename F>
+    static bool zipSegments(std::span<PtrVecView<T> const> a, std::span<PtrVecView<T> const> b, F &&f) {
+        size_type seg_a = 0, seg_b = 0, pos_a = 0, pos_b = 0;
+        while (seg_a < a.size() && seg_b < b.size()) {
+            auto const n = std::min(a[seg_a].size() - pos_a, b[seg_b].size() - pos_b);
+            if (n && f(a[seg_a].data() + pos_a, b[seg_b].data() + pos_b, n)) return true;
+            if ((pos_a += n) == a[seg_a].size()) {
+                ++seg_a;
+                pos_a = 0;
+            }
+            if ((pos_b += n) == b[seg_b].size()) {
+                ++seg_b;
+                pos_b = 0;
+            }
+        }
+        return false;
+    }
+
+    /// Index of the segment containing element `idx` (`count` for the total size), given `count + 1` offsets
+    static size_type segmentOf(size_type const *offsets, size_type count, size_type idx) {
+        return size_type(std::upper_bound(offsets, offsets + count + 1, idx) - offsets) - 1;
+    }
+};
+
+}  // namespace ut
+
+namespace std {
+/// Hashes the elements, not the pointers. Equal to the hash of an equal `ut::OwnPtrVec`.
+template<typename T>
+requires ut::detail::Hashable<T>
+struct hash<ut::ConcatPtrVecView<T>> {
+    std::size_t operator()(ut::ConcatPtrVecView<T> const &v) const {
+        auto seed = v.size();
+        for (auto const &seg : v.segments())
+            seed = ut::detail::hashElements(seg.data(), seg.size(), seed);
+        return seed;
+    }
+};
+}
+
+#endif  // CONCATPTRVECVIEW_HPP
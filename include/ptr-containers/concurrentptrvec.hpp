@@ -0,0 +1,342 @@
+#ifndef CONCURRENTPTRVEC_HPP
+#define CONCURRENTPTRVEC_HPP
+
+#include "template_helpers.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ut {
+
+namespace detail {
+    /** Storage for `ConcurrentPtrVec`: segment `k` holds `first_segment << k`
+     *  slots, so the segments never have to move.
+     */
+    template<typename T>
+    struct SegmentTable {
+        using Slot = std::atomic<T *>;
+
+        static constexpr std::size_t first_segment_bits = 6;
+        static constexpr std::size_t first_segment = std::size_t(1) << first_segment_bits;
+        static constexpr std::size_t max_segments = sizeof(std::size_t) * 8 - first_segment_bits;
+
+        std::atomic<Slot *> segments[max_segments] = {};
+
+        static constexpr std::size_t segmentOf(std::size_t idx) {
+            return std::size_t(std::bit_width((idx >> first_segment_bits) + 1) - 1);
+        }
+
+        static constexpr std::size_t segmentStart(std::size_t seg) {
+            return first_segment * ((std::size_t(1) << seg) - 1);
+        }
+
+        static constexpr std::size_t segmentSize(std::size_t seg) {
+            return first_segment << seg;
+        }
+
+        /// The slot at `idx`, whose segment has to exist
+        Slot &slot(std::size_t idx) const {
+            auto const seg = segmentOf(idx);
+            return segments[seg].load(std::memory_order_acquire)[idx - segmentStart(seg)];
+        }
+
+        /// The element at `idx`, or `nullptr` if it has not been stored yet
+        T *tryLoad(std::size_t idx) const {
+            auto const seg = segmentOf(idx);
+            auto const *slots = segments[seg].load(std::memory_order_acquire);
+            return slots ? slots[idx - segmentStart(seg)].load(std::memory_order_seq_cst) : nullptr;
+        }
+
+        /// The slot at `idx`, allocating its segment if needed
+        Slot &ensureSlot(std::size_t idx) {
+            auto const seg = segmentOf(idx);
+            auto *slots = segments[seg].load(std::memory_order_acquire);
+            if (!slots) {
+                auto *fresh = new Slot[segmentSize(seg)]();
+                if (segments[seg].compare_exchange_strong(slots, fresh, std::memory_order_acq_rel))
+                    slots = fresh;
+                else
+                    delete[] fresh;
+            }
+            return slots[idx - segmentStart(seg)];
+        }
+
+        ~SegmentTable() {
+            for (auto &seg : segments)
+                delete[] seg.load(std::memory_order_relaxed);
+        }
+    };
+}  // namespace detail
+
+/** An append-only vector of owning pointers to `T`, which any number of
+ *  threads can `push_back` to concurrently without locking.
+ *
+ * Each insertion reserves an index with an atomic compare-and-swap (once the
+ * segment holding that index exists) and stores the pointer into segmented
+ * storage, so existing pointers never move. An element becomes visible to
+ * readers (`size`, `operator[]`, `snapshot`) once it and all elements before
+ * it have been stored: readers always see a prefix of the vector.
+ *
+ * Elements are created with `new` and destroyed with `delete`.
+ *
+ * NOTE: Only the insertion functions and the read functions are thread safe.
+ *       `clear` and destruction must not run concurrently with anything else.
+ */
+template<typename T>
+class ConcurrentPtrVec {
+    using Table = detail::SegmentTable<T>;
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    class Snapshot;
+
+private:
+    std::unique_ptr<Table> m_table = std::make_unique<Table>();
+    /// Number of reserved indices
+    std::atomic<size_type> m_reserved = 0;
+    /// Length of the prefix of indices whose elements are stored
+    std::atomic<size_type> m_published = 0;
+
+public:  ////////// constructors //////////
+    ConcurrentPtrVec() = default;
+
+    ConcurrentPtrVec(ConcurrentPtrVec const &) = delete;
+    ConcurrentPtrVec &operator=(ConcurrentPtrVec const &) = delete;
+
+    ~ConcurrentPtrVec() {
+        static_assert(sizeof(T) >= 0, "Cannot have incomplete type in the constructor");
+        clear();
+    }
+
+public:  ////////// element access //////////
+
+    /// Requires `idx < size()`
+    T *operator[](size_type idx) const {
+        assert(idx < size());
+        return m_table->slot(idx).load(std::memory_order_relaxed);
+    }
+
+    /// A consistent view of the elements published so far
+    Snapshot snapshot() const {
+        return Snapshot(*m_table, size());
+    }
+
+public:  ////////// capacity //////////
+
+    /// Number of published elements
+    size_type size() const {
+        return m_published.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+public:  ////////// modifiers //////////
+
+    /// Returns the index of the new element
+    size_type push_back(std::unique_ptr<T> t) {
+        assert(t);
+        return publish(t.release());
+    }
+
+    /// Returns the index of the new element
+    template<detail::DerivedOrEqualTo<T> U>
+    size_type push_back(U &&t) {
+        using Ctor = std::remove_cvref_t<U>;
+        return publish(new Ctor(std::forward<U>(t)));
+    }
+
+    /// Construct new item in-place. Returns the index of the new element.
+    template<detail::DerivedOrEqualTo<T> U = T, typename... Args>
+    size_type emplace_back(Args &&...args) {
+        using Ctor = std::remove_cvref_t<U>;
+        return publish(new Ctor(std::forward<Args>(args)...));
+    }
+
+    /// NOTE: not thread safe
+    void clear() {
+        auto const reserved = m_reserved.load(std::memory_order_acquire);
+        for (size_type i = 0; i < reserved; ++i)
+            delete m_table->slot(i).exchange(nullptr, std::memory_order_relaxed);
+        m_reserved.store(0, std::memory_order_relaxed);
+        m_published.store(0, std::memory_order_release);
+    }
+
+private:
+    size_type publish(T *ptr) {
+        // Allocate the segment before reserving the index, so a failed
+        // allocation cannot leave a reserved slot that is never filled
+        auto idx = m_reserved.load(std::memory_order_relaxed);
+        typename Table::Slot *slot;
+        do {
+            try {
+                slot = &m_table->ensureSlot(idx);
+            } catch (...) {
+                delete ptr;
+                throw;
+            }
+        } while (!m_reserved.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed));
+        slot->store(ptr, std::memory_order_seq_cst);
+
+        // Extend the published prefix over every stored element. If an earlier
+        // element is still missing, the thread storing it will carry on from there.
+        // The store above and the loads below are sequentially consistent: of two
+        // threads storing neighbouring elements, at least one sees the other's.
+        auto published = m_published.load(std::memory_order_seq_cst);
+        while (published < m_reserved.load(std::memory_order_seq_cst) && m_table->tryLoad(published)) {
+            if (m_published.compare_exchange_weak(published, published + 1, std::memory_order_seq_cst))
+                ++published;
+        }
+        return idx;
+    }
+
+public:
+    /** A read-only view of a prefix of a `ConcurrentPtrVec`.
+     *
+     * The view stays valid (and unchanged) while elements are appended, until
+     * the vector is cleared or destroyed.
+     */
+    class Snapshot {
+        Table const *m_table = nullptr;
+        size_type m_size = 0;
+
+    public:
+        class const_iterator {
+            Table const *m_table = nullptr;
+            size_type m_idx = 0;
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T const *;
+            using difference_type = std::ptrdiff_t;
+            using reference = T const *;
+            using pointer = void;
+
+            const_iterator() = default;
+
+            const_iterator(Table const *table, size_type idx)
+                    : m_table(table)
+                    , m_idx(idx) { }
+
+            reference operator*() const {
+                return m_table->slot(m_idx).load(std::memory_order_relaxed);
+            }
+
+            reference operator[](difference_type n) const {
+                return *(*this + n);
+            }
+
+            const_iterator &operator++() {
+                ++m_idx;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                auto tmp = *this;
+                ++m_idx;
+                return tmp;
+            }
+
+            const_iterator &operator--() {
+                --m_idx;
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                auto tmp = *this;
+                --m_idx;
+                return tmp;
+            }
+
+            const_iterator &operator+=(difference_type n) {
+                m_idx = size_type(difference_type(m_idx) + n);
+                return *this;
+            }
+
+            const_iterator &operator-=(difference_type n) {
+                return *this += -n;
+            }
+
+            friend const_iterator operator+(const_iterator it, difference_type n) {
+                return it += n;
+            }
+
+            friend const_iterator operator+(difference_type n, const_iterator it) {
+                return it += n;
+            }
+
+            friend const_iterator operator-(const_iterator it, difference_type n) {
+                return it -= n;
+            }
+
+            friend difference_type operator-(const_iterator const &a, const_iterator const &b) {
+                return difference_type(a.m_idx) - difference_type(b.m_idx);
+            }
+
+            friend bool operator==(const_iterator const &a, const_iterator const &b) {
+                return a.m_idx == b.m_idx;
+            }
+
+            friend std::strong_ordering operator<=>(const_iterator const &a, const_iterator const &b) {
+                return a.m_idx <=> b.m_idx;
+            }
+        };
+
+        using iterator = const_iterator;
+
+        Snapshot() = default;
+
+        Snapshot(Table const &table, size_type size)
+                : m_table(&table)
+                , m_size(size) { }
+
+        T const *operator[](size_type idx) const {
+            assert(idx < m_size);
+            return m_table->slot(idx).load(std::memory_order_relaxed);
+        }
+
+        size_type size() const {
+            return m_size;
+        }
+
+        bool empty() const {
+            return m_size == 0;
+        }
+
+        const_iterator begin() const {
+            return const_iterator(m_table, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(m_table, m_size);
+        }
+
+        /// Call `f` on every element, one segment at a time
+        template<typename F>
+        void for_each(F &&f) const {
+            for (size_type seg = 0; m_size && Table::segmentStart(seg) < m_size; ++seg) {
+                auto const *slots = m_table->segments[seg].load(std::memory_order_acquire);
+                auto const count = std::min(Table::segmentSize(seg), m_size - Table::segmentStart(seg));
+                for (size_type i = 0; i < count; ++i)
+                    f(std::as_const(*slots[i].load(std::memory_order_relaxed)));
+            }
+        }
+    };
+};
+
+}  // namespace ut
+
+#endif  // CONCURRENTPTRVEC_HPP
@@ -1,16 +1,28 @@
 #ifndef CONTAINER_BASE_HPP
 #define CONTAINER_BASE_HPP
 
+#include "prefetch.hpp"
 #include "template_helpers.hpp"
 
 #ifndef assert
 #    include <cassert>
 #endif
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <compare>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <stack>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
 #define UT_CONTAINER_BASE_INJECT_DEPENDANT_NAMES(CName) \
 public:                                                 \
@@ -32,6 +44,75 @@ private:                                                \
 
 namespace ut {
 
+namespace detail {
+    template<typename D, typename Ptr, typename F>
+    void visitBatchAs(Ptr const *first, Ptr const *last, F &f) {
+        using Target = std::conditional_t<std::is_const_v<std::remove_pointer_t<Ptr>>, D const, D>;
+        for (; first != last; ++first)
+            f(*static_cast<Target *>(*first));
+    }
+
+    template<typename Ptr, typename F>
+    void forEachPrefetched(Ptr const *data, std::size_t size, std::size_t distance, F &f) {
+        for (std::size_t i = 0; i < size && i < distance; ++i)
+            UT_PREFETCH(data[i]);
+        for (std::size_t i = 0; i < size; ++i) {
+            if (i + distance < size) UT_PREFETCH(data[i + distance]);
+            f(*data[i]);
+        }
+    }
+
+    /// Number of elements `forEachAs` groups at a time, in buffers on the stack
+    inline constexpr std::size_t for_each_as_chunk = 256;
+
+    /// See `ContainerBase::for_each_as`
+    template<typename... Ds, typename Ptr, typename F>
+    void forEachAs(Ptr const *data, std::size_t size, F &f) {
+        static_assert((DerivedOrEqualTo<Ds, std::remove_cv_t<std::remove_pointer_t<Ptr>>> && ...));
+        constexpr std::size_t kinds = sizeof...(Ds) + 1;
+        static_assert(kinds <= 256, "too many types");
+        std::type_info const *types[kinds] = {&typeid(Ds)..., nullptr};
+
+        std::uint8_t kind[for_each_as_chunk];
+        Ptr sorted[for_each_as_chunk];
+        // Runs of one type are common, so remember the last match
+        std::type_info const *last_type = nullptr;
+        std::size_t last_kind = kinds - 1;
+
+        for (std::size_t first = 0; first < size; first += for_each_as_chunk) {
+            auto const *chunk = data + first;
+            auto const n = std::min(for_each_as_chunk, size - first);
+
+            // Classify each element once, then group them with a (stable) counting sort
+            std::array<std::size_t, kinds + 1> offsets {};
+            for (std::size_t i = 0; i < n; ++i) {
+                auto const &type = typeid(*chunk[i]);
+                if (&type != last_type) {
+                    std::size_t k = 0;
+                    while (k < kinds - 1 && *types[k] != type)
+                        ++k;
+                    last_type = &type;
+                    last_kind = k;
+                }
+                kind[i] = std::uint8_t(last_kind);
+                ++offsets[last_kind + 1];
+            }
+            for (std::size_t k = 0; k < kinds; ++k)
+                offsets[k + 1] += offsets[k];
+
+            auto pos = offsets;
+            for (std::size_t i = 0; i < n; ++i)
+                sorted[pos[kind[i]]++] = chunk[i];
+
+            [&]<std::size_t... Ks>(std::index_sequence<Ks...>) {
+                (visitBatchAs<Ds>(sorted + offsets[Ks], sorted + offsets[Ks + 1], f), ...);
+            }(std::index_sequence_for<Ds...> {});
+            for (auto i = offsets[kinds - 1]; i < n; ++i)
+                f(*sorted[i]);
+        }
+    }
+}  // namespace detail
+
 template<typename T,
     typename ValueType = T,
     typename StorageType = T *,  // Not one of the types used by the standard library
@@ -148,6 +229,58 @@ public:  ////////// iterators //////////
         return const_reverse_iterator {cbegin()};
     }
 
+public:  ////////// visitation //////////
+
+    /** A range over the elements which prefetches the pointee `distance`
+     *  elements ahead of the current one, for linear scans of large containers.
+     *
+     * The iterators are random access, so the range can be used with the
+     * standard algorithms. Prefetches are only issued when incrementing.
+     */
+    auto prefetched(size_type distance = default_prefetch_distance) requires std::is_pointer_v<Reference> {
+        return detail::PrefetchRange<std::remove_pointer_t<Iterator>>(m_data, m_data + m_size, distance);
+    }
+
+    auto prefetched(size_type distance = default_prefetch_distance) const requires std::is_pointer_v<ConstReference> {
+        return detail::PrefetchRange<std::remove_pointer_t<ConstIterator>>(m_data, m_data + m_size, distance);
+    }
+
+    /// Call `f` on every element (in index order), prefetching the element `distance` ahead
+    template<typename F>
+    void for_each_prefetched(F &&f, size_type distance = default_prefetch_distance)  //
+        requires std::is_pointer_v<Reference> {
+
+        detail::forEachPrefetched(m_data, m_size, distance, f);
+    }
+
+    template<typename F>
+    void for_each_prefetched(F &&f, size_type distance = default_prefetch_distance) const  //
+        requires std::is_pointer_v<ConstReference> {
+
+        detail::forEachPrefetched(static_cast<ConstReference const *>(m_data), m_size, distance, f);
+    }
+
+    /** Call `f` on every element, in batches of elements with the same dynamic type.
+     *
+     * Elements whose dynamic type is exactly one of `Ds` are passed as `D &`,
+     * so calls to their (final) member functions can be resolved statically
+     * and inlined. All other elements are passed as `T &`.
+     *
+     * The elements are grouped 256 at a time (in buffers on the stack, so
+     * nothing is allocated). Within each group of 256, batches are visited in
+     * the order of `Ds`, followed by the remaining elements, and within a
+     * batch elements are visited in index order.
+     */
+    template<typename... Ds, typename F>
+    void for_each_as(F &&f) requires std::is_pointer_v<Reference> {
+        detail::forEachAs<Ds...>(m_data, m_size, f);
+    }
+
+    template<typename... Ds, typename F>
+    void for_each_as(F &&f) const requires std::is_pointer_v<ConstReference> {
+        detail::forEachAs<Ds...>(static_cast<ConstReference const *>(m_data), m_size, f);
+    }
+
 public:  ////////// capacity //////////
     bool empty() const {
         return m_size == 0;
@@ -191,22 +324,171 @@ inline constexpr bool IsComparableContainerBaseV = IsComparableContainerBase<A,
 template<typename A, typename B>
 concept ComparableContainerBase = IsComparableContainerBaseV<A, B>;
 
+namespace detail {
+    /// Number of pointers checked at once with `memcmp` when comparing containers
+    inline constexpr std::size_t compare_block = 64;
+    /// Elements each thread compares in `equal_parallel`, fewer are not worth a thread
+    inline constexpr std::size_t parallel_compare_chunk = std::size_t(1) << 18;
+
+    /** Call `visit(i)` for each index in [first, last) where the pointers in `a` and
+     *  `b` differ, until it returns true. Runs of identical pointers are skipped
+     *  a block at a time with `memcmp`, without dereferencing them.
+     *
+     * Returns whether `visit` stopped the scan. Gives up early once `cancel` is set.
+     */
+    template<typename PA, typename PB, typename Visit>
+    bool scanDifferingPointers(PA const *a,
+        PB const *b,
+        std::size_t first,
+        std::size_t last,
+        Visit &visit,
+        std::atomic<bool> const *cancel = nullptr) {
+        static_assert(sizeof(PA) == sizeof(PB));
+        while (first < last) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+            auto const block_end = std::min(last, first + compare_block);
+            if (std::memcmp(a + first, b + first, sizeof(PA) * (block_end - first)) != 0) {
+                for (auto i = first; i < block_end; ++i)
+                    if (a[i] != b[i] && visit(i)) return true;
+            }
+            first = block_end;
+        }
+        return false;
+    }
+
+    /// Whether `*a[i] == *b[i]` for all `i < size`, comparing chunks on up to `threads` threads
+    template<typename PA, typename PB>
+    bool elementsEqual(PA const *a, PB const *b, std::size_t size, std::size_t threads = 1) {
+        auto differ = [a, b](std::size_t i) { return *a[i] != *b[i]; };
+        threads = std::min(threads, size / parallel_compare_chunk);
+        if (threads <= 1) return !scanDifferingPointers(a, b, 0, size, differ);
+
+        auto const chunk = (size + threads - 1) / threads;
+        std::atomic<bool> mismatch = false;
+        std::vector<std::exception_ptr> errors(threads);
+        auto compareChunk = [&](std::size_t t) {
+            try {
+                auto const last = std::min(size, (t + 1) * chunk);
+                if (scanDifferingPointers(a, b, t * chunk, last, differ, &mismatch)) mismatch = true;
+            } catch (...) {
+                errors[t] = std::current_exception();
+                mismatch = true;
+            }
+        };
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(threads - 1);
+            for (std::size_t t = 1; t < threads; ++t) {
+                try {
+                    workers.emplace_back(compareChunk, t);
+                } catch (...) {
+                    compareChunk(t);
+                }
+            }
+            compareChunk(0);
+        }
+        for (auto const &error : errors)
+            if (error) std::rethrow_exception(error);
+        return !mismatch;
+    }
+
+    /// `x <=> y`, or an ordering derived from `operator<` for types without `operator<=>`
+    template<typename T>
+    constexpr auto synthThreeWay(T const &x, T const &y)
+        requires std::three_way_comparable<T> || requires { x < y; }
+    {
+        if constexpr (std::three_way_comparable<T>)
+            return x <=> y;
+        else {
+            if (x < y) return std::weak_ordering::less;
+            if (y < x) return std::weak_ordering::greater;
+            return std::weak_ordering::equivalent;
+        }
+    }
+
+    template<typename T>
+    using SynthThreeWayResult = decltype(synthThreeWay(std::declval<T const &>(), std::declval<T const &>()));
+}  // namespace detail
+
+namespace detail {
+    /** Hash of the elements (not the pointers) of a container, as used by the `std::hash` specialisations.
+     *
+     * A container stored in several pieces is hashed by passing the result for
+     * each piece as the `seed` of the next, starting from its total size.
+     */
+    template<typename Ptr>
+    std::size_t hashElements(Ptr const *data, std::size_t size, std::size_t seed) {
+        using T = std::remove_cv_t<std::remove_pointer_t<Ptr>>;
+        for (std::size_t i = 0; i < size; ++i)
+            seed ^= std::hash<T>()(*data[i]) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+
+    template<typename Ptr>
+    std::size_t hashElements(Ptr const *data, std::size_t size) {
+        return hashElements(data, size, size);
+    }
+}  // namespace detail
+
+/** Compares the elements (not the pointers) of `a` and `b`.
+ *
+ * Elements at identical addresses are taken to be equal without being
+ * dereferenced, and identical pointer runs are skipped with `memcmp`.
+ */
 template<typename A, typename B>
 requires ComparableContainerBase<A, B>  //
     bool operator==(A const &a, B const &b) {
 
-    using S = std::common_type_t<typename A::size_type, typename B::size_type>;
+    if (detail::PtrCmp<A, B>()(&a, &b)) return true;
+
+    if (a.size() != b.size()) return false;
+
+    if (static_cast<void const *>(a.data()) == static_cast<void const *>(b.data())) return true;
+
+    return detail::elementsEqual(a.data(), b.data(), a.size());
+}
+
+/** Like `a == b`, but for very large containers splits the comparison across
+ *  up to `threads` threads (0 means `std::thread::hardware_concurrency()`),
+ *  which stop at the first mismatch found.
+ *
+ * The elements' `operator==` has to be safe to call concurrently. If it
+ * throws, the exception is rethrown once all threads have stopped.
+ */
+template<typename A, typename B>
+requires ComparableContainerBase<A, B>  //
+    bool equal_parallel(A const &a, B const &b, std::size_t threads = 0) {
 
     if (detail::PtrCmp<A, B>()(&a, &b)) return true;
 
     if (a.size() != b.size()) return false;
 
-    for (S i = 0; i < a.size(); ++i) {
-        if (a.data()[i] == b.data()[i]) continue;
-        if (*a.data()[i] != *b.data()[i]) return false;
-    }
+    if (static_cast<void const *>(a.data()) == static_cast<void const *>(b.data())) return true;
 
-    return true;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    return detail::elementsEqual(a.data(), b.data(), a.size(), threads);
+}
+
+/// Lexicographically compares the elements (not the pointers) of `a` and `b`
+template<typename A, typename B>
+requires ComparableContainerBase<A, B>  //
+    auto operator<=>(A const &a, B const &b) -> detail::SynthThreeWayResult<typename A::value_type> {
+
+    using S = std::common_type_t<typename A::size_type, typename B::size_type>;
+    using Result = detail::SynthThreeWayResult<typename A::value_type>;
+
+    Result result = std::strong_ordering::equal;
+    auto const common = std::min<S>(a.size(), b.size());
+    if (static_cast<void const *>(a.data()) != static_cast<void const *>(b.data())) {
+        auto const *a_data = a.data();
+        auto const *b_data = b.data();
+        auto order = [&](std::size_t i) {
+            result = detail::synthThreeWay<typename A::value_type>(*a_data[i], *b_data[i]);
+            return result != 0;
+        };
+        if (detail::scanDifferingPointers(a_data, b_data, 0, common, order)) return result;
+    }
+    return a.size() <=> b.size();
 }
 
 }  // namespace ut
@@ -0,0 +1,250 @@
+#ifndef COWPTR_HPP
+#define COWPTR_HPP
+#include "object_ops.hpp"
+#include "template_helpers.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace ut {
+
+namespace detail {
+    /// Shared state of `CowPtr`, followed by the object itself
+    struct CowHeader {
+        std::atomic<std::size_t> refs;
+        ObjectOps const *ops;
+
+        static std::size_t blockAlign(ObjectOps const &ops) {
+            return std::max(ops.align, alignof(CowHeader));
+        }
+
+        static std::size_t objectOffset(ObjectOps const &ops) {
+            return (sizeof(CowHeader) + ops.align - 1) / ops.align * ops.align;
+        }
+
+        /// Allocate a header (with a reference count of 1) and storage for an object with these `ops`.
+        static CowHeader *allocate(ObjectOps const &ops) {
+            void *mem = ::operator new(objectOffset(ops) + ops.size, std::align_val_t(blockAlign(ops)));
+            return ::new (mem) CowHeader {{1}, &ops};
+        }
+
+        /// Free the block. The object has to be destroyed first.
+        void deallocate() noexcept {
+            auto const align = blockAlign(*ops);
+            this->~CowHeader();
+            ::operator delete(static_cast<void *>(this), std::align_val_t(align));
+        }
+
+        void *object() {
+            return reinterpret_cast<std::byte *>(this) + objectOffset(*ops);
+        }
+    };
+}  // namespace detail
+
+/** A copy-on-write pointer to `T` (or a type derived from it) with value semantics.
+ *
+ * Copies share a single reference counted object. The object is copied (with
+ * its dynamic type) only when it is accessed through a non-const `get()`,
+ * `operator->` or `operator*` while it is shared. If its dynamic type is not
+ * copy constructible, that access throws `NonCopyableDynamicTypeError` and the
+ * object stays shared.
+ *
+ * NOTE: Pointers and references obtained through the non-const accessors are
+ *       only guaranteed to refer to this `CowPtr`'s object until it is next
+ *       copied. Do not write through them after that.
+ */
+template<typename T>
+class CowPtr {
+    template<typename U>
+    friend class CowPtr;
+
+private:
+    T *m_obj = nullptr;
+    detail::CowHeader *m_header = nullptr;
+
+public:  ////////// constructors //////////
+    CowPtr() {
+        construct<T>();
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    CowPtr(U &&obj) {
+        construct<std::remove_cvref_t<U>>(std::forward<U>(obj));
+    }
+
+    CowPtr(CowPtr const &other) {
+        share(other);
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    CowPtr(CowPtr<U> const &other) {
+        share(other);
+    }
+
+    CowPtr(CowPtr &&other) noexcept
+            : m_obj(std::exchange(other.m_obj, nullptr))
+            , m_header(std::exchange(other.m_header, nullptr)) { }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    CowPtr(CowPtr<U> &&other) noexcept
+            : m_obj(std::exchange(other.m_obj, nullptr))
+            , m_header(std::exchange(other.m_header, nullptr)) { }
+
+    CowPtr &operator=(CowPtr const &other) {
+        return *this = CowPtr(other);
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    CowPtr &operator=(CowPtr<U> const &other) {
+        return *this = CowPtr(other);
+    }
+
+    CowPtr &operator=(CowPtr &&other) noexcept {
+        if (this == &other) return *this;
+        reset();
+        m_obj = std::exchange(other.m_obj, nullptr);
+        m_header = std::exchange(other.m_header, nullptr);
+        return *this;
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    CowPtr &operator=(CowPtr<U> &&other) noexcept {
+        reset();
+        m_obj = std::exchange(other.m_obj, nullptr);
+        m_header = std::exchange(other.m_header, nullptr);
+        return *this;
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    CowPtr &operator=(U &&other) {
+        return *this = CowPtr(std::forward<U>(other));
+    }
+
+    ~CowPtr() {
+        reset();
+    }
+
+public:  ////////// functions //////////
+
+    /** Get the underlying pointer, copying the object first if it is shared.
+     *
+     * \note This API should rarely be used. To obtain a reference to the
+     *       contained object use `operator*`
+     */
+    T *get() {
+        detach();
+        return m_obj;
+    }
+
+    T const *get() const {
+        return m_obj;
+    }
+
+    /// Number of `CowPtr`s sharing the object
+    std::size_t use_count() const {
+        return m_header ? m_header->refs.load(std::memory_order_acquire) : 0;
+    }
+
+    bool unique() const {
+        return use_count() == 1;
+    }
+
+    void swap(CowPtr &other) noexcept {
+        std::swap(m_obj, other.m_obj);
+        std::swap(m_header, other.m_header);
+    }
+
+private:
+    template<typename U, typename... Args>
+    void construct(Args &&...args) {
+        auto *header = detail::CowHeader::allocate(detail::objectOps<U>);
+        try {
+            m_obj = ::new (header->object()) U(std::forward<Args>(args)...);
+        } catch (...) {
+            header->deallocate();
+            throw;
+        }
+        m_header = header;
+        assert(detail::mostDerived(m_obj) == m_header->object());
+    }
+
+    template<typename U>
+    void share(CowPtr<U> const &other) {
+        m_obj = other.m_obj;
+        m_header = other.m_header;
+        if (m_header) m_header->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void reset() noexcept {
+        if (!m_header) return;
+        if (m_header->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_header->ops->destroy(m_header->object());
+            m_header->deallocate();
+        }
+        m_obj = nullptr;
+        m_header = nullptr;
+    }
+
+    /// Make sure this is the only owner of the object
+    void detach() {
+        if (!m_header || m_header->refs.load(std::memory_order_acquire) == 1) return;
+        auto const &ops = *m_header->ops;
+        if (!ops.copy) throw NonCopyableDynamicTypeError(typeid(*m_obj));
+        auto *header = detail::CowHeader::allocate(ops);
+        try {
+            ops.copy(m_header->object(), header->object());
+        } catch (...) {
+            header->deallocate();
+            throw;
+        }
+        T *obj = detail::rebase(m_obj, m_header->object(), header->object());
+        reset();
+        m_obj = obj;
+        m_header = header;
+    }
+
+public:  ////////// operators //////////
+    T *operator->() {
+        return get();
+    }
+
+    T const *operator->() const {
+        return m_obj;
+    }
+
+    T &operator*() {
+        return *get();
+    }
+
+    T const &operator*() const {
+        return *m_obj;
+    }
+
+    template<typename U>
+    bool operator==(U const &u) const requires(detail::HasEqual<T, U>) {
+        return *m_obj == u;
+    }
+
+    template<typename U>
+    bool operator==(CowPtr<U> const &u) const requires(detail::HasEqual<T, U>) {
+        return static_cast<void const *>(m_obj) == static_cast<void const *>(u.m_obj) || *m_obj == *u.m_obj;
+    }
+};
+
+template<typename T>
+CowPtr(T t) -> CowPtr<T>;
+
+/// This overload is called in ADL use of swap
+template<typename T>
+void swap(ut::CowPtr<T> &a, ut::CowPtr<T> &b) {
+    a.swap(b);
+}
+}  // namespace ut
+
+#endif  // COWPTR_HPP
@@ -0,0 +1,332 @@
+#ifndef EPOCHPTRVEC_HPP
+#define EPOCHPTRVEC_HPP
+
+#include "ptrvecview.hpp"
+#include "template_helpers.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ut {
+
+/** A vector of owning pointers to `T` with one writer thread and any number
+ *  of reader threads, which read through epoch protected views instead of
+ *  taking a lock.
+ *
+ * Readers call `read()` and use the returned guard's `view()` (or the guard
+ * itself) for as long as they hold the guard. The writer never changes
+ * anything such a view can see: appending writes past the end of the
+ * published elements when possible, and every other modification publishes a
+ * new pointer buffer. Replaced buffers and removed elements are retired and
+ * freed once every reader which could still see them has released its guard.
+ *
+ * Retired memory is reclaimed without blocking once `reclaim_threshold`
+ * objects are waiting, as readers allow. `synchronize()` waits for the
+ * readers and frees everything retired so far.
+ *
+ * Elements are created with `new` and destroyed with `delete`.
+ *
+ * NOTE: All functions other than `read` must be called from the writer
+ *       thread. Erasing copies the pointer buffer, so it is O(n).
+ */
+template<typename T>
+class EpochPtrVec {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    static constexpr size_type reclaim_threshold = 64;
+
+    class ReadGuard;
+
+private:
+    struct Buffer {
+        /// Number of published elements, only ever grows
+        std::atomic<size_type> size = 0;
+        size_type cap;
+        std::unique_ptr<T *[]> data;
+
+        explicit Buffer(size_type capacity)
+                : cap(capacity)
+                , data(std::make_unique_for_overwrite<T *[]>(capacity)) { }
+    };
+
+    struct Retired {
+        std::vector<T *> elements;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+
+        size_type count() const {
+            return elements.size() + buffers.size();
+        }
+
+        void free() noexcept {
+            for (auto *ptr : elements)
+                delete ptr;
+            elements.clear();
+            buffers.clear();
+        }
+    };
+
+    struct alignas(64) ReaderCount {
+        std::atomic<size_type> count = 0;
+    };
+
+    std::atomic<Buffer *> m_current = nullptr;
+    std::atomic<unsigned> m_epoch = 0;
+    mutable ReaderCount m_readers[2];
+
+    // Writer only state
+    std::unique_ptr<Buffer> m_buffer;
+    size_type m_size = 0;
+    Retired m_retired;
+    /// Retired objects waiting for their grace period to end
+    Retired m_waiting;
+    /// Number of epoch flips done for `m_waiting` so far
+    int m_flips = 0;
+
+public:  ////////// constructors //////////
+    EpochPtrVec() = default;
+
+    EpochPtrVec(EpochPtrVec const &) = delete;
+    EpochPtrVec &operator=(EpochPtrVec const &) = delete;
+
+    /// NOTE: There must be no readers left
+    ~EpochPtrVec() {
+        static_assert(sizeof(T) >= 0, "Cannot have incomplete type in the constructor");
+        for (size_type i = 0; i < m_size; ++i)
+            delete m_buffer->data[i];
+        m_retired.free();
+        m_waiting.free();
+    }
+
+public:  ////////// readers //////////
+
+    /// Enter a read-side critical section. Can be called from any thread.
+    [[nodiscard]]
+    ReadGuard read() const {
+        return ReadGuard(*this);
+    }
+
+public:  ////////// writer access //////////
+
+    size_type size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    size_type capacity() const {
+        return m_buffer ? m_buffer->cap : 0;
+    }
+
+    T *operator[](size_type idx) const {
+        assert(idx < m_size);
+        return m_buffer->data[idx];
+    }
+
+    /// The elements as seen by the writer, valid until the next modification
+    PtrVecView<T> view() const {
+        return m_buffer ? PtrVecView<T>(m_buffer->data.get(), m_size) : PtrVecView<T>();
+    }
+
+public:  ////////// modifiers //////////
+
+    void push_back(std::unique_ptr<T> t) {
+        assert(t);
+        append(t.get());
+        t.release();
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    void push_back(U &&t) {
+        using Ctor = std::remove_cvref_t<U>;
+        auto ptr = std::make_unique<Ctor>(std::forward<U>(t));
+        append(ptr.get());
+        ptr.release();
+    }
+
+    template<detail::DerivedOrEqualTo<T> U = T, typename... Args>
+    T *emplace_back(Args &&...args) {
+        using Ctor = std::remove_cvref_t<U>;
+        auto ptr = std::make_unique<Ctor>(std::forward<Args>(args)...);
+        append(ptr.get());
+        return ptr.release();
+    }
+
+    void reserve(size_type new_capacity) {
+        if (new_capacity > capacity()) republish(new_capacity);
+    }
+
+    void pop_back() {
+        assert(m_size > 0);
+        erase(m_size - 1);
+    }
+
+    void erase(size_type idx) {
+        erase(idx, idx + 1);
+    }
+
+    /// Erase the elements with indices in [from, to)
+    void erase(size_type from, size_type to) {
+        assert(from <= to);
+        assert(to <= m_size);
+        if (from == to) return;
+        m_retired.elements.reserve(m_retired.elements.size() + (to - from));
+        m_retired.buffers.reserve(m_retired.buffers.size() + 1);
+        auto fresh = std::make_unique<Buffer>(m_buffer->cap);
+        std::copy(m_buffer->data.get(), m_buffer->data.get() + from, fresh->data.get());
+        std::copy(m_buffer->data.get() + to, m_buffer->data.get() + m_size, fresh->data.get() + from);
+        m_retired.elements.insert(
+            m_retired.elements.end(), m_buffer->data.get() + from, m_buffer->data.get() + to);
+        m_size -= to - from;
+        publish(std::move(fresh));
+        maybeReclaim();
+    }
+
+    void clear() {
+        if (!m_size) return;
+        erase(0, m_size);
+    }
+
+public:  ////////// reclamation //////////
+
+    /// Number of retired objects (elements and buffers) which have not been freed yet
+    size_type retired() const {
+        return m_retired.count() + m_waiting.count();
+    }
+
+    /** Free whatever retired objects no reader can see anymore, without
+     *  blocking. Returns whether everything retired so far was freed.
+     */
+    bool try_reclaim() {
+        if (m_waiting.count() == 0) {
+            if (m_retired.count() == 0) return true;
+            std::swap(m_waiting, m_retired);
+            m_flips = 0;
+        }
+        // Flip the epoch twice, each time waiting for the readers which registered
+        // under the previous one to leave. One flip is not enough, since a reader
+        // could have read the epoch just before it but registered just after it.
+        while (true) {
+            auto const epoch = m_epoch.load(std::memory_order_relaxed);
+            if (m_flips > 0 && m_readers[(epoch + 1) & 1].count.load(std::memory_order_seq_cst) != 0)  //
+                return false;
+            if (m_flips == 2) break;
+            m_epoch.store(epoch + 1, std::memory_order_seq_cst);
+            ++m_flips;
+        }
+        m_waiting.free();
+        m_flips = 0;
+        return m_retired.count() == 0;
+    }
+
+    /// Wait for all current readers to leave, then free everything retired so far
+    void synchronize() {
+        while (!try_reclaim())
+            std::this_thread::yield();
+    }
+
+private:
+    void append(T *ptr) {
+        // Readers never see the slots past the end of the current buffer, since
+        // every removal publishes a new buffer
+        if (m_size == capacity()) republish(std::max<size_type>(capacity(), 2) * 3 / 2);
+        m_buffer->data[m_size] = ptr;
+        m_buffer->size.store(++m_size, std::memory_order_release);
+    }
+
+    /// Publish a copy of the elements in a buffer of `cap` slots
+    void republish(size_type cap) {
+        assert(cap >= m_size);
+        m_retired.buffers.reserve(m_retired.buffers.size() + 1);
+        auto fresh = std::make_unique<Buffer>(cap);
+        if (m_buffer) std::copy(m_buffer->data.get(), m_buffer->data.get() + m_size, fresh->data.get());
+        publish(std::move(fresh));
+        maybeReclaim();
+    }
+
+    /// `m_size` has to be the number of valid elements in `fresh`
+    void publish(std::unique_ptr<Buffer> fresh) noexcept {
+        fresh->size.store(m_size, std::memory_order_relaxed);
+        m_current.store(fresh.get(), std::memory_order_seq_cst);
+        if (m_buffer) m_retired.buffers.push_back(std::move(m_buffer));
+        m_buffer = std::move(fresh);
+    }
+
+    void maybeReclaim() {
+        if (retired() >= reclaim_threshold) try_reclaim();
+    }
+
+public:
+    /** Keeps the elements a reader sees alive. Must not outlive the vector.
+     *
+     * Behaves like a read-only `PtrVecView<T>` of the elements at the time
+     * the guard was created.
+     */
+    class ReadGuard {
+        EpochPtrVec const *m_vec;
+        unsigned m_idx;
+        PtrVecView<T> m_view;
+
+    public:
+        explicit ReadGuard(EpochPtrVec const &vec)
+                : m_vec(&vec) {
+            m_idx = vec.m_epoch.load(std::memory_order_seq_cst) & 1;
+            vec.m_readers[m_idx].count.fetch_add(1, std::memory_order_seq_cst);
+            if (auto *buf = vec.m_current.load(std::memory_order_seq_cst))
+                m_view = PtrVecView<T>(buf->data.get(), buf->size.load(std::memory_order_acquire));
+        }
+
+        ReadGuard(ReadGuard &&other) noexcept
+                : m_vec(std::exchange(other.m_vec, nullptr))
+                , m_idx(other.m_idx)
+                , m_view(other.m_view) { }
+
+        ReadGuard(ReadGuard const &) = delete;
+        ReadGuard &operator=(ReadGuard const &) = delete;
+        ReadGuard &operator=(ReadGuard &&) = delete;
+
+        ~ReadGuard() {
+            if (m_vec) m_vec->m_readers[m_idx].count.fetch_sub(1, std::memory_order_release);
+        }
+
+        PtrVecView<T> const &view() const {
+            return m_view;
+        }
+
+        size_type size() const {
+            return m_view.size();
+        }
+
+        bool empty() const {
+            return m_view.empty();
+        }
+
+        T const *operator[](size_type idx) const {
+            return m_view[idx];
+        }
+
+        auto begin() const {
+            return m_view.begin();
+        }
+
+        auto end() const {
+            return m_view.end();
+        }
+    };
+};
+
+}  // namespace ut
+
+#endif  // EPOCHPTRVEC_HPP
@@ -0,0 +1,69 @@
+#ifndef GROWTH_HPP
+#define GROWTH_HPP
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+
+namespace ut {
+
+/** A policy deciding the new capacity of a container which has to hold
+ *  `required` elements, but only has room for `old` (`old < required`).
+ */
+template<typename G>
+concept GrowthPolicy = requires(std::size_t n) {
+    { G::grow(n, n) } -> std::convertible_to<std::size_t>;
+};
+
+/// Grow the capacity by a factor of `Num / Den` (the default is 1.5)
+template<std::size_t Num = 3, std::size_t Den = 2>
+struct GeometricGrowth {
+    static_assert(Num > Den && Den > 0, "the capacity has to grow");
+
+    static constexpr std::size_t grow(std::size_t old, std::size_t required) {
+        auto cap = std::max<std::size_t>(old, 2);
+        while (cap < required)
+            cap = std::max(cap * Num / Den, cap + 1);
+        return cap;
+    }
+};
+
+/// Grow the capacity to the next multiple of `Chunk`
+template<std::size_t Chunk>
+struct ChunkGrowth {
+    static_assert(Chunk > 0);
+
+    static constexpr std::size_t grow(std::size_t, std::size_t required) {
+        return (required + Chunk - 1) / Chunk * Chunk;
+    }
+};
+
+/// Grow the capacity to the next power of two
+struct PowerOfTwoGrowth {
+    static constexpr std::size_t grow(std::size_t, std::size_t required) {
+        return std::bit_ceil(std::max<std::size_t>(required, 2));
+    }
+};
+
+/** Keep the pointer buffer of an `OwnPtrVec` in memory from its element
+ *  allocator (a `new[]` array with the default allocator). Growing the buffer
+ *  allocates a new one and copies the pointers over.
+ */
+struct AllocatorBuffer { };
+
+/** Where an `OwnPtrVec` keeps its pointer buffer: `AllocatorBuffer`, or a
+ *  type managing the memory itself, independently of the element allocator
+ *  (see `MallocBuffer`). `reallocate` keeps the first `min(old_bytes, new_bytes)`
+ *  bytes, and may grow the buffer in place.
+ */
+template<typename B>
+concept BufferPolicy = std::same_as<B, AllocatorBuffer> || requires(void *ptr, std::size_t bytes) {
+    { B::allocate(bytes) } -> std::same_as<void *>;
+    B::deallocate(ptr, bytes);
+    { B::reallocate(ptr, bytes, bytes) } -> std::same_as<void *>;
+};
+
+}  // namespace ut
+
+#endif  // GROWTH_HPP
@@ -0,0 +1,170 @@
+#ifndef KEY_SORT_HPP
+#define KEY_SORT_HPP
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ut {
+
+namespace detail {
+    /// A key extracted from an element, stored next to the element's pointer
+    template<typename Key, typename T>
+    struct KeyedPtr {
+        Key key;
+        T *ptr;
+    };
+
+    template<typename Proj, typename T>
+    using ProjectedKey = std::remove_cvref_t<std::invoke_result_t<Proj &, T &>>;
+
+    template<typename Key, typename Comp>
+    concept RadixSortable = std::integral<Key>
+                         && (std::same_as<Comp, std::less<>> || std::same_as<Comp, std::less<Key>>
+                             || std::same_as<Comp, std::greater<>> || std::same_as<Comp, std::greater<Key>>);
+
+    /// Below this many elements a comparison sort beats radix sort
+    inline constexpr std::size_t radix_sort_threshold = 256;
+
+    template<typename Key, typename T, typename Proj>
+    std::vector<KeyedPtr<Key, T>> extractKeys(T *const *data, std::size_t size, Proj &proj) {
+        std::vector<KeyedPtr<Key, T>> keyed;
+        keyed.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+            keyed.push_back({std::invoke(proj, *data[i]), data[i]});
+        return keyed;
+    }
+
+    template<typename Key, typename T>
+    void storePointers(std::vector<KeyedPtr<Key, T>> const &keyed, T **data) noexcept {
+        for (std::size_t i = 0; i < keyed.size(); ++i)
+            data[i] = keyed[i].ptr;
+    }
+
+    /// Map `key` to an unsigned integer with the same (or, if `descending`, reversed) order
+    template<std::integral Key>
+    auto radixKey(Key key, bool descending) {
+        using U = std::make_unsigned_t<std::conditional_t<std::is_same_v<Key, bool>, unsigned char, Key>>;
+        auto u = static_cast<U>(key);
+        if constexpr (std::is_signed_v<Key>) u = static_cast<U>(u ^ (U(1) << (sizeof(U) * CHAR_BIT - 1)));
+        return descending ? static_cast<U>(~u) : u;
+    }
+
+    /// Stable LSD radix sort, one byte per pass. Passes in which all elements share the digit are skipped.
+    template<std::unsigned_integral U, typename T>
+    void radixSort(std::vector<KeyedPtr<U, T>> &keyed) {
+        constexpr std::size_t passes = sizeof(U);
+        std::array<std::array<std::size_t, 256>, passes> counts {};
+        for (auto const &e : keyed)
+            for (std::size_t p = 0; p < passes; ++p)
+                ++counts[p][(e.key >> (p * CHAR_BIT)) & 0xff];
+
+        std::vector<KeyedPtr<U, T>> tmp(keyed.size());
+        for (std::size_t p = 0; p < passes; ++p) {
+            auto &count = counts[p];
+            if (std::ranges::any_of(count, [&](std::size_t c) { return c == keyed.size(); })) continue;
+            std::size_t offset = 0;
+            for (auto &c : count)
+                offset += std::exchange(c, offset);
+            for (auto const &e : keyed)
+                tmp[count[(e.key >> (p * CHAR_BIT)) & 0xff]++] = e;
+            keyed.swap(tmp);
+        }
+    }
+
+    /// Stable sort of the pointers at `data` by `comp(proj(a), proj(b))`, projecting each element once
+    template<typename T, typename Proj, typename Comp>
+    void sortByKey(T **data, std::size_t size, Proj &proj, Comp &comp) {
+        using Key = ProjectedKey<Proj, T>;
+        if constexpr (RadixSortable<Key, Comp>) {
+            if (size >= radix_sort_threshold) {
+                constexpr bool descending
+                    = std::same_as<Comp, std::greater<>> || std::same_as<Comp, std::greater<Key>>;
+                using U = decltype(radixKey(Key(), false));
+                std::vector<KeyedPtr<U, T>> keyed;
+                keyed.reserve(size);
+                for (std::size_t i = 0; i < size; ++i)
+                    keyed.push_back({radixKey(static_cast<Key>(std::invoke(proj, *data[i])), descending), data[i]});
+                radixSort(keyed);
+                storePointers(keyed, data);
+                return;
+            }
+        }
+        auto keyed = extractKeys<Key>(data, size, proj);
+        std::stable_sort(keyed.begin(), keyed.end(), [&](auto const &a, auto const &b) { return comp(a.key, b.key); });
+        storePointers(keyed, data);
+    }
+
+    /** `std::partial_sort` of the pointers at `data`, projecting each element once.
+     *
+     * Only the best `middle` keys are kept, in a bounded heap, so a small top-k
+     * of a large vector needs little memory. The rest of the pointers keep
+     * their relative order.
+     */
+    template<typename T, typename Proj, typename Comp>
+    void partialSortByKey(T **data, std::size_t size, std::size_t middle, Proj &proj, Comp &comp) {
+        if (middle == 0) return;
+        using Key = ProjectedKey<Proj, T>;
+        struct Entry {
+            Key key;
+            std::size_t idx;
+        };
+        // A max-heap: its front is the worst of the keys kept so far
+        auto const worse = [&](Entry const &a, Entry const &b) { return comp(a.key, b.key); };
+        std::vector<Entry> heap;
+        heap.reserve(middle);
+        for (std::size_t i = 0; i < size; ++i) {
+            Key key = std::invoke(proj, *data[i]);
+            if (heap.size() < middle) {
+                heap.push_back({std::move(key), i});
+                std::push_heap(heap.begin(), heap.end(), worse);
+            } else if (comp(key, heap.front().key)) {
+                std::pop_heap(heap.begin(), heap.end(), worse);
+                heap.back() = {std::move(key), i};
+                std::push_heap(heap.begin(), heap.end(), worse);
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), worse);
+
+        // Move the other pointers to the back, then put the selected ones in front
+        std::vector<T *> selected;
+        selected.reserve(middle);
+        std::vector<std::size_t> taken;
+        taken.reserve(middle);
+        for (auto const &e : heap) {
+            selected.push_back(data[e.idx]);
+            taken.push_back(e.idx);
+        }
+        std::sort(taken.begin(), taken.end());
+        auto next_taken = taken.rbegin();
+        std::size_t out = size;
+        for (std::size_t i = size; i-- > 0;) {
+            if (next_taken != taken.rend() && *next_taken == i)
+                ++next_taken;
+            else
+                data[--out] = data[i];
+        }
+        std::copy(selected.begin(), selected.end(), data);
+    }
+
+    /// `std::nth_element` of the pointers at `data`, projecting each element once
+    template<typename T, typename Proj, typename Comp>
+    void nthElementByKey(T **data, std::size_t size, std::size_t nth, Proj &proj, Comp &comp) {
+        auto keyed = extractKeys<ProjectedKey<Proj, T>>(data, size, proj);
+        std::nth_element(keyed.begin(),
+            keyed.begin() + std::ptrdiff_t(nth),
+            keyed.end(),
+            [&](auto const &a, auto const &b) { return comp(a.key, b.key); });
+        storePointers(keyed, data);
+    }
+}  // namespace detail
+
+}  // namespace ut
+
+#endif  // KEY_SORT_HPP
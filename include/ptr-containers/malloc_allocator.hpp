@@ -0,0 +1,273 @@
+#ifndef MALLOC_ALLOCATOR_HPP
+#define MALLOC_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+namespace ut {
+
+namespace detail {
+    /// Size of the pages `mmap` hands out (or 1 if it is not used)
+    inline std::size_t pageSize() {
+#ifdef __linux__
+        static std::size_t const size = std::size_t(sysconf(_SC_PAGESIZE));
+        return size;
+#else
+        return 1;
+#endif
+    }
+
+    inline std::size_t roundUp(std::size_t bytes, std::size_t to) {
+        return (bytes + to - 1) / to * to;
+    }
+}  // namespace detail
+
+/** Maps allocations of at least `Threshold` bytes directly (on Linux), see `MallocAllocator`.
+ *
+ * Mapped allocations are resized with `mremap`, which moves the pages
+ * instead of copying their contents.
+ */
+template<std::size_t Threshold = 4 * 1024 * 1024>
+struct PageMapping {
+#ifdef __linux__
+    static constexpr std::size_t threshold = Threshold;
+#else
+    static constexpr std::size_t threshold = ~std::size_t(0);
+#endif
+
+    /// Returns `nullptr` on failure
+    static void *map([[maybe_unused]] std::size_t bytes) {
+#ifdef __linux__
+        void *ptr = mmap(nullptr, size(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+        return nullptr;
+#endif
+    }
+
+    static void unmap([[maybe_unused]] void *ptr, [[maybe_unused]] std::size_t bytes) noexcept {
+#ifdef __linux__
+        munmap(ptr, size(bytes));
+#endif
+    }
+
+    /// Returns `nullptr` on failure, in which case `ptr` is unchanged
+    static void *remap(
+        [[maybe_unused]] void *ptr, [[maybe_unused]] std::size_t old_bytes, [[maybe_unused]] std::size_t new_bytes) {
+#ifdef __linux__
+        void *res = mremap(ptr, size(old_bytes), size(new_bytes), MREMAP_MAYMOVE);
+        return res == MAP_FAILED ? nullptr : res;
+#else
+        return nullptr;
+#endif
+    }
+
+private:
+    static std::size_t size(std::size_t bytes) {
+        return detail::roundUp(bytes, detail::pageSize());
+    }
+};
+
+/** Maps allocations of at least `Threshold` bytes as 2 MiB aligned memory
+ *  backed by transparent huge pages (on Linux), see `MallocAllocator`.
+ *
+ * This saves TLB misses when scanning very large buffers. If `Prefault` is
+ * set, the memory is faulted in when it is mapped rather than on first use.
+ *
+ * NOTE: Whether huge pages are used is up to the kernel, see
+ *       /sys/kernel/mm/transparent_hugepage/enabled (`madvise` or `always`).
+ */
+template<std::size_t Threshold = 2 * 1024 * 1024, bool Prefault = false>
+struct HugePageMapping {
+    static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+#ifdef __linux__
+    static constexpr std::size_t threshold = Threshold;
+#else
+    static constexpr std::size_t threshold = ~std::size_t(0);
+#endif
+
+    /// Returns `nullptr` on failure
+    static void *map([[maybe_unused]] std::size_t bytes) {
+#ifdef __linux__
+        auto const len = size(bytes);
+        // Over-map, then trim to a huge page aligned region
+        void *raw = mmap(nullptr, len + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return nullptr;
+        auto *start = static_cast<std::byte *>(raw);
+        auto *aligned = reinterpret_cast<std::byte *>(
+            detail::roundUp(reinterpret_cast<std::uintptr_t>(start), huge_page_size));
+        if (aligned != start) munmap(start, std::size_t(aligned - start));
+        auto const tail = huge_page_size - std::size_t(aligned - start);
+        if (tail) munmap(aligned + len, tail);
+        advise(aligned, len);
+        return aligned;
+#else
+        return nullptr;
+#endif
+    }
+
+    static void unmap([[maybe_unused]] void *ptr, [[maybe_unused]] std::size_t bytes) noexcept {
+#ifdef __linux__
+        munmap(ptr, size(bytes));
+#endif
+    }
+
+    /** Grow or shrink in place if possible. Returns `nullptr` on failure,
+     *  in which case `ptr` is unchanged.
+     */
+    static void *remap(
+        [[maybe_unused]] void *ptr, [[maybe_unused]] std::size_t old_bytes, [[maybe_unused]] std::size_t new_bytes) {
+#ifdef __linux__
+        // Moving the mapping could lose the alignment, so the caller copies instead
+        void *res = mremap(ptr, size(old_bytes), size(new_bytes), 0);
+        if (res == MAP_FAILED) return nullptr;
+        if (new_bytes > old_bytes) advise(res, size(new_bytes));
+        return res;
+#else
+        return nullptr;
+#endif
+    }
+
+private:
+    static std::size_t size(std::size_t bytes) {
+        return detail::roundUp(bytes, huge_page_size);
+    }
+
+#ifdef __linux__
+    static void advise(void *ptr, std::size_t len) {
+        madvise(ptr, len, MADV_HUGEPAGE);
+        if constexpr (Prefault) {
+            auto const page = detail::pageSize();
+            for (std::size_t i = 0; i < len; i += page)
+                static_cast<std::byte volatile *>(ptr)[i] = static_cast<std::byte volatile *>(ptr)[i];
+        }
+    }
+#endif
+};
+
+/** An allocator using `malloc` and `free`, which can grow allocations in
+ *  place with `reallocate`.
+ *
+ * Allocations of at least `Mapping::threshold` bytes are mapped directly
+ * instead (see `PageMapping` and `HugePageMapping`).
+ *
+ * To grow the pointer buffer of an `OwnPtrVec` this way, use `MallocBuffer`.
+ */
+template<typename T, typename Mapping = PageMapping<>>
+class MallocAllocator {
+    static constexpr bool over_aligned = alignof(T) > alignof(std::max_align_t);
+
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    static constexpr std::size_t mmap_threshold = Mapping::threshold;
+
+    MallocAllocator() = default;
+
+    template<typename U>
+    MallocAllocator(MallocAllocator<U, Mapping> const &) { }
+
+    [[nodiscard]]
+    T *allocate(std::size_t n) {
+        auto const bytes = std::max<std::size_t>(n * sizeof(T), 1);
+        void *ptr;
+        if (isMapped(bytes))
+            ptr = Mapping::map(bytes);
+        else if constexpr (over_aligned)
+            ptr = std::aligned_alloc(alignof(T), detail::roundUp(bytes, alignof(T)));
+        else
+            ptr = std::malloc(bytes);
+        if (!ptr) throw std::bad_alloc();
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        auto const bytes = std::max<std::size_t>(n * sizeof(T), 1);
+        if (isMapped(bytes))
+            Mapping::unmap(ptr, bytes);
+        else
+            std::free(ptr);
+    }
+
+    /** Resize the allocation at `ptr` (returned by `allocate(old_n)`) to hold
+     *  `new_n` objects, keeping the first `min(old_n, new_n)` of them.
+     *
+     * The objects are relocated bitwise, so `T` has to be trivially copyable.
+     */
+    [[nodiscard]]
+    T *reallocate(T *ptr, std::size_t old_n, std::size_t new_n) requires std::is_trivially_copyable_v<T> {
+        auto const old_bytes = std::max<std::size_t>(old_n * sizeof(T), 1);
+        auto const new_bytes = std::max<std::size_t>(new_n * sizeof(T), 1);
+        if (isMapped(old_bytes) && isMapped(new_bytes)) {
+            if (void *res = Mapping::remap(ptr, old_bytes, new_bytes)) return static_cast<T *>(res);
+        } else if (!over_aligned && !isMapped(old_bytes) && !isMapped(new_bytes)) {
+            void *res = std::realloc(ptr, new_bytes);
+            if (!res) throw std::bad_alloc();
+            return static_cast<T *>(res);
+        }
+        auto *tmp = allocate(new_n);
+        std::memcpy(static_cast<void *>(tmp), ptr, std::min(old_bytes, new_bytes));
+        deallocate(ptr, old_n);
+        return tmp;
+    }
+
+    template<typename U>
+    bool operator==(MallocAllocator<U, Mapping> const &) const {
+        return true;
+    }
+
+private:
+    static bool isMapped(std::size_t bytes) {
+        return bytes >= Mapping::threshold;
+    }
+};
+
+/** A buffer policy for `OwnPtrVec` (see `BufferPolicy`) which keeps the
+ *  pointer buffer in memory from a `MallocAllocator`, whatever allocator the
+ *  elements use.
+ *
+ * The buffer grows in place with `realloc` where possible, or with `mremap`
+ * once it reaches `Mapping::threshold` bytes.
+ */
+template<typename Mapping = PageMapping<>>
+struct MallocBuffer {
+    using Allocator = MallocAllocator<std::byte, Mapping>;
+
+    static constexpr std::size_t mmap_threshold = Mapping::threshold;
+
+    static void *allocate(std::size_t bytes) {
+        return Allocator().allocate(bytes);
+    }
+
+    static void deallocate(void *ptr, std::size_t bytes) noexcept {
+        Allocator().deallocate(static_cast<std::byte *>(ptr), bytes);
+    }
+
+    static void *reallocate(void *ptr, std::size_t old_bytes, std::size_t new_bytes) {
+        return Allocator().reallocate(static_cast<std::byte *>(ptr), old_bytes, new_bytes);
+    }
+};
+
+/** A buffer policy which puts `OwnPtrVec` pointer buffers of at least
+ *  `Threshold` bytes on huge pages, see `HugePageMapping`.
+ *
+ * Use as `OwnPtrVec<T, std::allocator<T>, GeometricGrowth<>, HugePageBuffer<>>`;
+ * the elements are still allocated by the element allocator.
+ */
+template<std::size_t Threshold = 2 * 1024 * 1024, bool Prefault = false>
+using HugePageBuffer = MallocBuffer<HugePageMapping<Threshold, Prefault>>;
+
+}  // namespace ut
+
+#endif  // MALLOC_ALLOCATOR_HPP
@@ -0,0 +1,390 @@
+#ifndef MAPPEDPTRVEC_HPP
+#define MAPPEDPTRVEC_HPP
+
+#include "serialization.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <ranges>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace ut {
+
+namespace detail {
+    /// Start of a `MappedPtrVec` image
+    struct MappedHeader {
+        static constexpr std::uint64_t magic_value = 0x3156504d50505455;  // "UTPPMPV1"
+
+        std::uint64_t magic;
+        std::uint32_t element_size;
+        std::uint32_t element_align;
+        /// Number of elements
+        std::uint64_t size;
+        /// Position of the offset table, one `std::uint64_t` per element
+        std::uint64_t offsets;
+        /// Size of the whole image
+        std::uint64_t bytes;
+    };
+}  // namespace detail
+
+/** A read-only vector of pointers to `T` backed by a file, which is mapped
+ *  into memory (on Linux) instead of being deserialised.
+ *
+ * The image stores the position of each element relative to its start
+ * instead of a `T *`, so it can be mapped at any address, and processes
+ * mapping the same file share its pages in the page cache. Elements are
+ * accessed through `T const *` as with a `PtrVecView`.
+ *
+ * Images are written with `save`. Only trivially copyable types can be
+ * stored, and images are not portable between platforms with different
+ * endianness or layout of `T`.
+ *
+ * Where `mmap` is not available the image is read into memory.
+ */
+template<typename T>
+class MappedPtrVec {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are stored as their object representation");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T const *;
+    using const_reference = T const *;
+
+private:
+    std::byte const *m_image = nullptr;
+    std::size_t m_bytes = 0;
+    std::uint64_t const *m_offsets = nullptr;
+    size_type m_size = 0;
+    bool m_mapped = false;
+
+    static constexpr std::size_t image_align = std::max(alignof(T), alignof(detail::MappedHeader));
+
+public:
+    class const_iterator {
+        std::byte const *m_image = nullptr;
+        std::uint64_t const *m_offset = nullptr;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T const *;
+        using difference_type = std::ptrdiff_t;
+        using reference = T const *;
+        using pointer = void;
+
+        const_iterator() = default;
+
+        const_iterator(std::byte const *image, std::uint64_t const *offset)
+                : m_image(image)
+                , m_offset(offset) { }
+
+        reference operator*() const {
+            return reinterpret_cast<T const *>(m_image + *m_offset);
+        }
+
+        reference operator[](difference_type n) const {
+            return reinterpret_cast<T const *>(m_image + m_offset[n]);
+        }
+
+        const_iterator &operator++() {
+            ++m_offset;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto tmp = *this;
+            ++m_offset;
+            return tmp;
+        }
+
+        const_iterator &operator--() {
+            --m_offset;
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            auto tmp = *this;
+            --m_offset;
+            return tmp;
+        }
+
+        const_iterator &operator+=(difference_type n) {
+            m_offset += n;
+            return *this;
+        }
+
+        const_iterator &operator-=(difference_type n) {
+            m_offset -= n;
+            return *this;
+        }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend const_iterator operator+(difference_type n, const_iterator it) {
+            return it += n;
+        }
+
+        friend const_iterator operator-(const_iterator it, difference_type n) {
+            return it -= n;
+        }
+
+        friend difference_type operator-(const_iterator const &a, const_iterator const &b) {
+            return a.m_offset - b.m_offset;
+        }
+
+        friend bool operator==(const_iterator const &a, const_iterator const &b) {
+            return a.m_offset == b.m_offset;
+        }
+
+        friend std::strong_ordering operator<=>(const_iterator const &a, const_iterator const &b) {
+            return std::compare_three_way()(a.m_offset, b.m_offset);
+        }
+    };
+
+    using iterator = const_iterator;
+
+public:  ////////// constructors //////////
+    MappedPtrVec() = default;
+
+    /// Map the image at `path`. Throws `SerializationError` if it is not a valid image for `T`.
+    explicit MappedPtrVec(std::filesystem::path const &path) {
+        load(path);
+        try {
+            validate();
+        } catch (...) {
+            unload();
+            throw;
+        }
+    }
+
+    MappedPtrVec(MappedPtrVec const &) = delete;
+    MappedPtrVec &operator=(MappedPtrVec const &) = delete;
+
+    MappedPtrVec(MappedPtrVec &&other) noexcept
+            : m_image(std::exchange(other.m_image, nullptr))
+            , m_bytes(std::exchange(other.m_bytes, 0))
+            , m_offsets(std::exchange(other.m_offsets, nullptr))
+            , m_size(std::exchange(other.m_size, 0))
+            , m_mapped(std::exchange(other.m_mapped, false)) { }
+
+    MappedPtrVec &operator=(MappedPtrVec &&other) noexcept {
+        MappedPtrVec tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    ~MappedPtrVec() {
+        unload();
+    }
+
+    /** Write an image of the elements pointed to by `range` (such as an
+     *  `OwnPtrVec<T>` or `PtrVecView<T>`) to `path`, in order.
+     */
+    template<std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R const>, T const *>
+    static void save(std::filesystem::path const &path, R const &range) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::system_error(errno, std::generic_category(), "cannot open " + path.string());
+        save(file, range);
+        if (!file.flush()) throw SerializationError("failed to write " + path.string());
+    }
+
+    /// Write an image of the elements pointed to by `range` to `out`
+    template<std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R const>, T const *>
+    static void save(std::ostream &out, R const &range) {
+        std::vector<T const *> elements;
+        if constexpr (std::ranges::sized_range<R const>) elements.reserve(std::ranges::size(range));
+        for (T const *ptr : range)
+            elements.push_back(ptr);
+
+        detail::MappedHeader header {};
+        header.magic = detail::MappedHeader::magic_value;
+        header.element_size = std::uint32_t(sizeof(T));
+        header.element_align = std::uint32_t(alignof(T));
+        header.size = elements.size();
+        header.offsets = sizeof(detail::MappedHeader);
+        auto const data = alignUp(header.offsets + sizeof(std::uint64_t) * elements.size(), alignof(T));
+        header.bytes = data + sizeof(T) * elements.size();
+
+        std::vector<std::uint64_t> offsets(elements.size());
+        for (std::size_t i = 0; i < elements.size(); ++i)
+            offsets[i] = data + sizeof(T) * i;
+
+        BinaryWriter writer(out);
+        writer.write(header);
+        if (!offsets.empty()) writer.write_bytes(offsets.data(), sizeof(std::uint64_t) * offsets.size());
+        std::byte const padding[alignof(T)] = {};
+        writer.write_bytes(padding, data - header.offsets - sizeof(std::uint64_t) * offsets.size());
+        for (T const *ptr : elements)
+            writer.write_bytes(ptr, sizeof(T));
+    }
+
+public:  ////////// element access //////////
+    T const *operator[](size_type idx) const {
+        assert(idx < m_size);
+        return reinterpret_cast<T const *>(m_image + m_offsets[idx]);
+    }
+
+    T const *front() const {
+        return (*this)[0];
+    }
+
+    T const *back() const {
+        return (*this)[m_size - 1];
+    }
+
+    size_type size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(m_image, m_offsets);
+    }
+
+    const_iterator end() const {
+        return const_iterator(m_image, m_offsets + m_size);
+    }
+
+    template<typename F>
+    void for_each(F &&f) const {
+        for (size_type i = 0; i < m_size; ++i)
+            f(*(*this)[i]);
+    }
+
+    /// Whether the image is mapped from the file (rather than read into memory)
+    bool is_mapped() const {
+        return m_mapped;
+    }
+
+    void swap(MappedPtrVec &other) noexcept {
+        std::swap(m_image, other.m_image);
+        std::swap(m_bytes, other.m_bytes);
+        std::swap(m_offsets, other.m_offsets);
+        std::swap(m_size, other.m_size);
+        std::swap(m_mapped, other.m_mapped);
+    }
+
+private:
+    static constexpr std::uint64_t alignUp(std::uint64_t offset, std::uint64_t align) {
+        return (offset + align - 1) / align * align;
+    }
+
+    void load(std::filesystem::path const &path) {
+#ifdef __linux__
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "cannot open " + path.string());
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            auto const error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "cannot stat " + path.string());
+        }
+        m_bytes = std::size_t(st.st_size);
+        if (m_bytes > 0) {
+            void *image = ::mmap(nullptr, m_bytes, PROT_READ, MAP_SHARED, fd, 0);
+            auto const error = errno;
+            ::close(fd);
+            if (image == MAP_FAILED) throw std::system_error(error, std::generic_category(), "cannot map " + path.string());
+            m_image = static_cast<std::byte const *>(image);
+            m_mapped = true;
+        } else
+            ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) throw std::system_error(errno, std::generic_category(), "cannot open " + path.string());
+        m_bytes = std::size_t(file.tellg());
+        file.seekg(0);
+        auto *image = static_cast<std::byte *>(::operator new(m_bytes, std::align_val_t(image_align)));
+        m_image = image;
+        if (!file.read(reinterpret_cast<char *>(image), std::streamsize(m_bytes))) {
+            unload();
+            throw SerializationError("cannot read " + path.string());
+        }
+#endif
+    }
+
+    void unload() noexcept {
+        if (!m_image) return;
+#ifdef __linux__
+        ::munmap(const_cast<std::byte *>(m_image), m_bytes);
+#else
+        ::operator delete(const_cast<std::byte *>(m_image), std::align_val_t(image_align));
+#endif
+        m_image = nullptr;
+        m_offsets = nullptr;
+        m_bytes = 0;
+        m_size = 0;
+        m_mapped = false;
+    }
+
+    /// Check the header and that every element lies within the image
+    void validate() {
+        detail::MappedHeader header;
+        if (m_bytes < sizeof(header)) throw SerializationError("not a MappedPtrVec image");
+        std::memcpy(&header, m_image, sizeof(header));
+        if (header.magic != detail::MappedHeader::magic_value || header.bytes != m_bytes)
+            throw SerializationError("not a MappedPtrVec image");
+        if (header.element_size != sizeof(T) || header.element_align != alignof(T))
+            throw SerializationError("image was saved with a different element type");
+        if (header.offsets % alignof(std::uint64_t) || header.offsets > m_bytes
+            || header.size > (m_bytes - header.offsets) / sizeof(std::uint64_t))
+            throw SerializationError("corrupt MappedPtrVec image");
+
+        auto const *offsets = reinterpret_cast<std::uint64_t const *>(m_image + header.offsets);
+        for (std::uint64_t i = 0; i < header.size; ++i) {
+            if (offsets[i] % alignof(T) || sizeof(T) > m_bytes || offsets[i] > m_bytes - sizeof(T))
+                throw SerializationError("corrupt MappedPtrVec image");
+        }
+        m_offsets = offsets;
+        m_size = size_type(header.size);
+    }
+};
+
+/// This overload is called in ADL use of swap
+template<typename T>
+void swap(ut::MappedPtrVec<T> &a, ut::MappedPtrVec<T> &b) {
+    a.swap(b);
+}
+
+}  // namespace ut
+
+namespace std {
+/// This overload is called when swap is invoked as `std::swap`
+template<typename T>
+void swap(ut::MappedPtrVec<T> &a, ut::MappedPtrVec<T> &b) {
+    a.swap(b);
+}
+}
+
+#endif  // MAPPEDPTRVEC_HPP
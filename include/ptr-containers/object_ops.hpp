@@ -0,0 +1,223 @@
+#ifndef OBJECT_OPS_HPP
+#define OBJECT_OPS_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace ut::detail {
+
+/** Type erased description of how to handle an object of some dynamic type.
+ *
+ * All functions take (and return) the address of the complete (most derived)
+ * object, see `mostDerived`.
+ *
+ * The move and copy functions are `nullptr` if the type cannot be move or copy
+ * constructed respectively.
+ */
+struct ObjectOps {
+    std::size_t size;
+    std::size_t align;
+    bool trivially_destructible;
+    /// Objects can be relocated with `memcpy`
+    bool trivially_copyable;
+    bool nothrow_move;
+    void (*destroy)(void *obj) noexcept;
+    /// Move construct an object at `to` from the one at `from`. `from` is not destroyed.
+    void (*move)(void *from, void *to);
+    /// Copy construct an object at `to` from the one at `from`.
+    void (*copy)(void const *from, void *to);
+    /// Move construct an object with `new`. `from` is not destroyed.
+    void *(*move_new)(void *from);
+    /// Copy construct an object with `new`.
+    void *(*copy_new)(void const *from);
+};
+
+template<typename U>
+void destroyObject(void *obj) noexcept {
+    std::destroy_at(static_cast<U *>(obj));
+}
+
+template<typename U>
+void moveObject(void *from, void *to) {
+    ::new (to) U(std::move(*static_cast<U *>(from)));
+}
+
+template<typename U>
+void copyObject(void const *from, void *to) {
+    ::new (to) U(*static_cast<U const *>(from));
+}
+
+template<typename U>
+void *moveNewObject(void *from) {
+    return new U(std::move(*static_cast<U *>(from)));
+}
+
+template<typename U>
+void *copyNewObject(void const *from) {
+    return new U(*static_cast<U const *>(from));
+}
+
+template<typename U>
+consteval auto moveObjectFn() -> void (*)(void *, void *) {
+    if constexpr (std::is_move_constructible_v<U>)
+        return &moveObject<U>;
+    else
+        return nullptr;
+}
+
+template<typename U>
+consteval auto copyObjectFn() -> void (*)(void const *, void *) {
+    if constexpr (std::is_copy_constructible_v<U>)
+        return &copyObject<U>;
+    else
+        return nullptr;
+}
+
+template<typename U>
+consteval auto moveNewObjectFn() -> void *(*)(void *) {
+    if constexpr (std::is_move_constructible_v<U>)
+        return &moveNewObject<U>;
+    else
+        return nullptr;
+}
+
+template<typename U>
+consteval auto copyNewObjectFn() -> void *(*)(void const *) {
+    if constexpr (std::is_copy_constructible_v<U>)
+        return &copyNewObject<U>;
+    else
+        return nullptr;
+}
+
+template<typename U>
+inline constexpr ObjectOps objectOps {
+    sizeof(U),
+    alignof(U),
+    std::is_trivially_destructible_v<U>,
+    std::is_trivially_copyable_v<U>,
+    std::is_nothrow_move_constructible_v<U>,
+    &destroyObject<U>,
+    moveObjectFn<U>(),
+    copyObjectFn<U>(),
+    moveNewObjectFn<U>(),
+    copyNewObjectFn<U>(),
+};
+
+/** The `ObjectOps` of polymorphic types, by their `typeid`.
+ *
+ * Containers register every type they construct, so the operations of an
+ * object can be found from its dynamic type later on instead of being stored
+ * next to it.
+ */
+class ObjectOpsRegistry {
+    std::shared_mutex m_mutex;
+    std::unordered_map<std::type_index, ObjectOps const *> m_ops;
+
+public:
+    static ObjectOpsRegistry &instance() {
+        static ObjectOpsRegistry registry;
+        return registry;
+    }
+
+    void add(std::type_info const &type, ObjectOps const *ops) {
+        std::unique_lock lock(m_mutex);
+        m_ops.emplace(type, ops);
+    }
+
+    /// `nullptr` if `type` was never registered
+    ObjectOps const *find(std::type_info const &type) {
+        std::shared_lock lock(m_mutex);
+        auto it = m_ops.find(type);
+        return it == m_ops.end() ? nullptr : it->second;
+    }
+};
+
+/// Make the operations of `U` available to `dynamicObjectOps`. Cheap after the first call.
+template<typename U>
+void registerObjectOps() {
+    if constexpr (std::is_polymorphic_v<U> && !std::is_abstract_v<U>) {
+        static bool const registered = (ObjectOpsRegistry::instance().add(typeid(U), &objectOps<U>), true);
+        (void)registered;
+    }
+}
+
+/** The operations of the dynamic type of `obj`, or `nullptr` if it is a
+ *  polymorphic type which was never registered with `registerObjectOps`.
+ *
+ * Non-polymorphic objects are taken to be of their static type.
+ */
+template<typename T>
+ObjectOps const *dynamicObjectOps(T const &obj) {
+    using U = std::remove_cv_t<T>;
+    if constexpr (!std::is_polymorphic_v<U>)
+        return &objectOps<U>;
+    else {
+        if constexpr (!std::is_abstract_v<U>)
+            if (typeid(obj) == typeid(U)) return &objectOps<U>;
+        return ObjectOpsRegistry::instance().find(typeid(obj));
+    }
+}
+
+/** Get the address of the complete object `ptr` is a part of.
+ *
+ * NOTE: for non-polymorphic types this is `ptr` itself, so a non-polymorphic
+ *       base has to be the first subobject of whatever is stored through it.
+ */
+template<typename T>
+[[nodiscard]]
+void *mostDerived(T *ptr) {
+    using Ptr = std::conditional_t<std::is_const_v<T>, void const *, void *>;
+    if constexpr (std::is_polymorphic_v<T>)
+        return const_cast<void *>(static_cast<void const *>(dynamic_cast<Ptr>(ptr)));
+    else
+        return const_cast<void *>(static_cast<void const *>(ptr));
+}
+
+/** Given `ptr` which points into the complete object at `from`, get the
+ *  corresponding pointer into an object of the same dynamic type at `to`.
+ */
+template<typename T>
+[[nodiscard]]
+T *rebase(T *ptr, void const *from, void *to) {
+    auto const offset = reinterpret_cast<std::byte const *>(ptr) - static_cast<std::byte const *>(from);
+    return std::launder(reinterpret_cast<T *>(static_cast<std::byte *>(to) + offset));
+}
+
+}  // namespace ut::detail
+
+namespace ut {
+
+/// Thrown when an object has to be copied through a base pointer, but its dynamic type is not known
+class UnknownDynamicTypeError : public std::logic_error {
+public:
+    explicit UnknownDynamicTypeError(std::type_info const &type)
+            : std::logic_error(std::string("dynamic type not registered: ") + type.name()) { }
+};
+
+/// Thrown when an object has to be copied through a base pointer, but its dynamic type is not copy constructible
+class NonCopyableDynamicTypeError : public std::logic_error {
+public:
+    explicit NonCopyableDynamicTypeError(std::type_info const &type)
+            : std::logic_error(std::string("dynamic type not copyable: ") + type.name()) { }
+};
+
+/** Make objects of type `U` copyable through a base pointer when they were
+ *  not constructed by a container (e.g. adopted from a `std::unique_ptr`).
+ */
+template<typename U>
+void register_dynamic_type() {
+    detail::registerObjectOps<U>();
+}
+
+}  // namespace ut
+
+#endif  // OBJECT_OPS_HPP
@@ -1,21 +1,145 @@
 #ifndef OWNPTRVEC_HPP
 #define OWNPTRVEC_HPP
 
+#include "arena.hpp"
 #include "container_base.hpp"
+#include "growth.hpp"
+#include "key_sort.hpp"
+#include "object_ops.hpp"
 #include "ptrvecview.hpp"
 #include "template_helpers.hpp"
+#include "type_filter.hpp"
 
 #ifndef assert
 #    include <cassert>
 #endif
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <ranges>
 #include <stack>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
 namespace ut {
 
+namespace detail {
+    /// Stored immediately before every element allocated through an allocator
+    struct ElementHeader {
+        ObjectOps const *ops;
+    };
+
+    /// Offset of an object with alignment `align` from the start of its block
+    constexpr std::size_t elementOffset(std::size_t align) {
+        return std::max(align, sizeof(ElementHeader));
+    }
+
+    constexpr std::size_t elementBlockAlign(std::size_t align) {
+        return std::max(align, alignof(ElementHeader));
+    }
+
+    constexpr std::size_t elementBlockSize(ObjectOps const &ops) {
+        return elementOffset(ops.align) + ops.size;
+    }
+
+    [[nodiscard]]
+    inline ElementHeader *elementHeader(void *obj) {
+        return std::launder(reinterpret_cast<ElementHeader *>(static_cast<std::byte *>(obj) - sizeof(ElementHeader)));
+    }
+
+    /// Allocators which can hand out untyped memory directly (such as `std::pmr::polymorphic_allocator`)
+    template<typename Alloc>
+    concept BytesAllocator = requires(Alloc &a, void *p, std::size_t n) {
+        a.allocate_bytes(n, n);
+        a.deallocate_bytes(p, n, n);
+    };
+
+    /** Allocators which can free all of their memory at once, if nothing else is
+     *  using it (see `ArenaAllocator`). Individual deallocations are no-ops.
+     */
+    template<typename Alloc>
+    concept RegionAllocator = requires(Alloc &a) {
+        { a.try_release() } -> std::same_as<bool>;
+    };
+
+    /// Call `pred` with a reference to the element at `ptr` if possible, otherwise with `ptr` itself
+    template<typename Pred, typename T>
+    bool invokeOnElement(Pred &pred, T *ptr) {
+        if constexpr (std::is_invocable_v<Pred &, T &>)
+            return static_cast<bool>(pred(*ptr));
+        else
+            return static_cast<bool>(pred(ptr));
+    }
+
+    /// Allocators which take over destroying erased elements (see `DeferredAllocator`)
+    template<typename Alloc>
+    concept DeferringAllocator = requires(Alloc &a, typename Alloc::value_type *const *p, std::size_t n) {
+        a.defer(p, n);
+    };
+
+    template<std::size_t Align>
+    struct alignas(Align) AllocUnit {
+        std::byte bytes[Align];
+    };
+
+    inline constexpr std::size_t max_element_align = 4096;
+
+    /// Allocate `bytes` bytes aligned to `align` from any allocator
+    template<typename Alloc, std::size_t Align = alignof(std::max_align_t)>
+    void *allocateBytes(Alloc &alloc, std::size_t bytes, std::size_t align) {
+        if constexpr (BytesAllocator<Alloc>)
+            return alloc.allocate_bytes(bytes, align);
+        else {
+            if constexpr (Align < max_element_align)
+                if (align > Align) return allocateBytes<Alloc, Align * 2>(alloc, bytes, align);
+            assert(align <= Align);
+            using UnitAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<AllocUnit<Align>>;
+            UnitAlloc unit_alloc(alloc);
+            return std::allocator_traits<UnitAlloc>::allocate(unit_alloc, (bytes + Align - 1) / Align);
+        }
+    }
+
+    template<typename Alloc, std::size_t Align = alignof(std::max_align_t)>
+    void deallocateBytes(Alloc &alloc, void *ptr, std::size_t bytes, std::size_t align) noexcept {
+        if constexpr (BytesAllocator<Alloc>)
+            alloc.deallocate_bytes(ptr, bytes, align);
+        else {
+            if constexpr (Align < max_element_align)
+                if (align > Align) return deallocateBytes<Alloc, Align * 2>(alloc, ptr, bytes, align);
+            using UnitAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<AllocUnit<Align>>;
+            UnitAlloc unit_alloc(alloc);
+            std::allocator_traits<UnitAlloc>::deallocate(
+                unit_alloc, static_cast<AllocUnit<Align> *>(ptr), (bytes + Align - 1) / Align);
+        }
+    }
+
+    /// Allocate a block for an object described by `ops`. Returns the (uninitialised) storage for the object.
+    template<typename Alloc>
+    void *allocateElement(Alloc &alloc, ObjectOps const &ops) {
+        auto *block = static_cast<std::byte *>(
+            allocateBytes(alloc, elementBlockSize(ops), elementBlockAlign(ops.align)));
+        void *obj = block + elementOffset(ops.align);
+        ::new (static_cast<void *>(elementHeader(obj))) ElementHeader {&ops};
+        return obj;
+    }
+
+    /// Free the block of the object at `obj`. The object has to be destroyed first.
+    template<typename Alloc>
+    void deallocateElement(Alloc &alloc, void *obj) noexcept {
+        auto const &ops = *elementHeader(obj)->ops;
+        deallocateBytes(alloc,
+            static_cast<std::byte *>(obj) - elementOffset(ops.align),
+            elementBlockSize(ops),
+            elementBlockAlign(ops.align));
+    }
+}  // namespace detail
+
 #define BASE                             \
     ContainerBase<T,                     \
         /*ValueType      = */ T,         \
@@ -25,32 +149,85 @@ namespace ut {
         /*Iterator       = */ T **,      \
         /*ConstIterator  = */ T *const *>
 
-template<typename T>
+/** A vector of owning pointers to `T`.
+ *
+ * With the default allocator elements are created with `new` and destroyed
+ * with `delete`, and the pointer buffer is a `new[]` array.
+ *
+ * With any other allocator both the pointer buffer and every element are
+ * allocated through (a rebound copy of) `Alloc`. Each element is then
+ * preceded by a small header recording its dynamic type, so it can be
+ * destroyed and deallocated without knowing its type statically. In this mode
+ * the APIs which transfer ownership through `std::unique_ptr` or raw pointers
+ * (`release`, `release_back` and the `unique_ptr` overloads) are unavailable.
+ *
+ * `Growth` decides the new capacity when the buffer is full (see growth.hpp).
+ * `Buffer` decides where the pointer buffer lives: by default it comes from
+ * the allocator as described above, while a policy such as `MallocBuffer`
+ * manages it separately and can grow it in place, avoiding the copy.
+ *
+ * If the allocator provides `defer(ptrs, n)` (see `DeferredAllocator`), erased elements
+ * are handed to it instead of being destroyed.
+ */
+template<typename T,
+    typename Alloc = std::allocator<T>,
+    GrowthPolicy Growth = GeometricGrowth<>,
+    BufferPolicy Buffer = AllocatorBuffer>
 class OwnPtrVec : public BASE {
     using Base = BASE;
 
     UT_CONTAINER_BASE_INJECT_DEPENDANT_NAMES(Base);
 
+    template<typename, typename, GrowthPolicy, BufferPolicy>
+    friend class OwnPtrVec;
+
+public:
+    using allocator_type = Alloc;
+
 private:
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using BufferAlloc = typename AllocTraits::template rebind_alloc<T *>;
+    using BufferTraits = std::allocator_traits<BufferAlloc>;
 
-    size_type m_cap = 0;
+    static constexpr bool uses_new = std::is_same_v<Alloc, std::allocator<T>>;
+    static constexpr bool uses_region = detail::RegionAllocator<Alloc>;
+    /// Whether the buffer is managed by `Buffer` rather than allocated with the elements
+    static constexpr bool own_buffer = !std::is_same_v<Buffer, AllocatorBuffer>;
+    static constexpr bool defers = detail::DeferringAllocator<Alloc>;
 
-    static constexpr auto multiplier = 1.5;
+    size_type m_cap = 0;
+    [[no_unique_address]] Alloc m_alloc;
+    /// Whether an element which is not trivially destructible was added since the vector was last empty
+    [[no_unique_address]] std::conditional_t<uses_region, bool, detail::Empty> m_needs_destroy {};
 
 public:  ////////// constructors //////////
 
-    static OwnPtrVec fromReserve(size_type res) {
-        return OwnPtrVec(new T *[res], 0, res);
+    static OwnPtrVec fromReserve(size_type res, Alloc const &alloc = Alloc()) {
+        auto vec = OwnPtrVec(alloc);
+        vec.m_data = vec.allocateBuffer(res);
+        vec.m_cap = res;
+        return vec;
     }
 
     template<typename... Args>
-    static OwnPtrVec make(Args &&...args) {
-        auto vec = OwnPtrVec(new T *[sizeof...(Args)], 0, sizeof...(Args));
-        vec.makeImpl(std::forward<Args>(args)...);
+    static OwnPtrVec make(Args &&...args)  //
+        requires(!(detail::SameAsRemoveCVRef<Args, std::allocator_arg_t> || ...)) {
+
+        return make(std::allocator_arg, Alloc(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    static OwnPtrVec make(std::allocator_arg_t, Alloc const &alloc, Args &&...args) {
+        auto vec = fromReserve(sizeof...(Args), alloc);
+        if constexpr (sizeof...(Args)) vec.makeImpl(std::forward<Args>(args)...);
         return vec;
     }
 
-    OwnPtrVec() {
+    OwnPtrVec() requires std::default_initializable<Alloc>
+            : OwnPtrVec(Alloc()) { }
+
+    explicit OwnPtrVec(Alloc const &alloc)
+            : m_alloc(alloc) {
         m_data = nullptr;
         m_size = 0;
         m_cap = 0;
@@ -59,18 +236,33 @@ public:  ////////// constructors //////////
     OwnPtrVec(OwnPtrVec const &) = delete;
     OwnPtrVec &operator=(OwnPtrVec const &) = delete;
 
-    OwnPtrVec(OwnPtrVec &&other) {
-        m_size = 0;
-        m_cap = 0;
-        m_data = nullptr;
-        *this = std::move(other);
+    OwnPtrVec(OwnPtrVec &&other)
+            : m_alloc(std::move(other.m_alloc)) {
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_cap = std::exchange(other.m_cap, 0);
+        m_needs_destroy = std::exchange(other.m_needs_destroy, {});
+        other.detachRegion();
     }
 
+    /** If `Alloc` does not propagate on move assignment and the allocators
+     *  compare unequal, each element is moved into memory from this vector's
+     *  allocator (invoking the move constructor of its dynamic type).
+     */
     OwnPtrVec &operator=(OwnPtrVec &&other) {
+        if (this == &other) return *this;
         deleteData();
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value)
+            m_alloc = std::move(other.m_alloc);
+        else if (!AllocTraits::is_always_equal::value && m_alloc != other.m_alloc) {
+            relocateFrom(other);
+            return *this;
+        }
         std::swap(m_data, other.m_data);
         std::swap(m_size, other.m_size);
         std::swap(m_cap, other.m_cap);
+        std::swap(m_needs_destroy, other.m_needs_destroy);
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) other.detachRegion();
         return *this;
     }
 
@@ -90,7 +282,7 @@ public:  ////////// constructors //////////
         assert(from <= to);
         assert(from <= m_size);
         assert((to == npos || to <= m_size));
-        return PtrVecView<T>(begin() + from, (to == npos ? m_size : to) - from);
+        return PtrVecView<T>(m_data + from, (to == npos ? m_size : to) - from);
     }
 
     /** Create a (non-owning) view of the vector.
@@ -103,11 +295,80 @@ public:  ////////// constructors //////////
         return PtrVecView<T>(from, to);
     }
 
-private:
-    OwnPtrVec(T **d, size_type s, size_type c) {
-        m_data = d;
-        m_size = s;
-        m_cap = c;
+    /** A view of the elements which are `Derived` objects (including
+     *  subclasses of `Derived`), yielding `Derived *`.
+     *
+     * The indices of the matching elements are cached per type until the
+     * vector is next modified, so repeated calls don't `dynamic_cast` every
+     * element again. The view is invalidated by any modification.
+     *
+     * Non-const access to the pointers (`begin`, `end`, `data`, ...) drops the
+     * cache too, as the elements could be reordered through it.
+     *
+     * NOTE: Iterators obtained before `view_of` must not be used to reorder
+     *       the elements until the next non-const access.
+     */
+    template<typename Derived>
+    TypeFilteredView<T, Derived> view_of() requires std::is_polymorphic_v<T> && std::derived_from<Derived, T> {
+        if (!m_data) return {};
+        auto *cache = typeFilters(m_data, m_cap);
+        if (!cache) {
+            cache = new detail::TypeFilterCache;
+            setTypeFilters(m_data, m_cap, cache);
+        }
+        return TypeFilteredView<T, Derived>(m_data, cache->indices(typeid(Derived), [this] {
+            return collectTypeIndices<Derived>();
+        }));
+    }
+
+    /// Only reads the cache (computing the indices afresh on a miss), so it can be called from several threads at once
+    template<typename Derived>
+    TypeFilteredView<T const, Derived const> view_of() const
+        requires std::is_polymorphic_v<T> && std::derived_from<Derived, T> {
+        if (!m_data) return {};
+        if (auto const *cache = typeFilters(m_data, m_cap))
+            if (auto indices = cache->find(typeid(Derived)))
+                return TypeFilteredView<T const, Derived const>(m_data, std::move(indices));
+        return TypeFilteredView<T const, Derived const>(m_data, collectTypeIndices<Derived>());
+    }
+
+    allocator_type get_allocator() const {
+        return m_alloc;
+    }
+
+    /** Create a deep copy of the vector, copying every element with its dynamic type.
+     *
+     * The copies (and the pointer buffer) are allocated in a single contiguous
+     * block of a new arena, laid out in index order.
+     *
+     * With the default allocator the dynamic type of each element is looked
+     * up by its `typeid`. Every type the vector constructs is registered for
+     * this; elements adopted from a `std::unique_ptr` need their type to be
+     * registered with `register_dynamic_type`, or `UnknownDynamicTypeError` is
+     * thrown (before anything is copied). If an element's dynamic type cannot
+     * be copied, `NonCopyableDynamicTypeError` is thrown, also up front.
+     */
+    OwnPtrVec<T, ArenaAllocator<T>> clone() const {
+
+        std::size_t bytes = m_size * sizeof(T *) + alignof(T *);
+        for (size_type i = 0; i < m_size; ++i) {
+            auto const &ops = elementObjectOps(m_data[i]);
+            if (!ops.copy) throw NonCopyableDynamicTypeError(typeid(*m_data[i]));
+            bytes += detail::elementBlockSize(ops) + detail::elementBlockAlign(ops.align) - 1;
+        }
+        ArenaAllocator<T> alloc;
+        alloc.arena().reserve(bytes);
+        auto copy = OwnPtrVec<T, ArenaAllocator<T>>::fromReserve(m_size, alloc);
+        for (; copy.m_size < m_size; ++copy.m_size) {
+            T *src = m_data[copy.m_size];
+            void *from = detail::mostDerived(src);
+            auto const &ops = elementObjectOps(src);
+            void *to = detail::allocateElement(copy.m_alloc, ops);
+            ops.copy(from, to);
+            copy.m_needs_destroy = copy.m_needs_destroy || !ops.trivially_destructible;
+            copy.m_data[copy.m_size] = detail::rebase(src, from, to);
+        }
+        return copy;
     }
 
 public:  ////////// element access //////////
@@ -130,7 +391,8 @@ public:  ////////// element access //////////
      *  be reset after the call.
      */
     [[nodiscard("returns owning pointer")]]
-    T **release() {
+    T **release() requires uses_new && (!own_buffer) {
+        invalidateTypeFilters();
         auto **ptr = m_data;
         m_data = nullptr;
         m_size = 0;
@@ -140,10 +402,49 @@ public:  ////////// element access //////////
 
     /// Caller owns returned memory.
     [[nodiscard("object will be deleted at the end of the function call if not saved to temporary")]]
-    std::unique_ptr<T> release_back() {
+    std::unique_ptr<T> release_back() requires uses_new {
+        invalidateTypeFilters();
         return std::unique_ptr<T> {m_data[--m_size]};
     }
 
+    // The pointers can be reordered through any of these, so they drop the `view_of` cache
+
+    using Base::data;
+    using Base::rbegin;
+    using Base::rend;
+
+    T **data() {
+        invalidateTypeFilters();
+        return m_data;
+    }
+
+    iterator begin() {
+        invalidateTypeFilters();
+        return m_data;
+    }
+
+    iterator end() {
+        invalidateTypeFilters();
+        return m_data + m_size;
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator {end()};
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator {begin()};
+    }
+
+    auto prefetched(size_type distance = default_prefetch_distance) {
+        invalidateTypeFilters();
+        return Base::prefetched(distance);
+    }
+
+    auto prefetched(size_type distance = default_prefetch_distance) const {
+        return Base::prefetched(distance);
+    }
+
 public:  ////////// capacity //////////
     void reserve(size_type new_capacity) {
         if (new_capacity <= m_cap) return;
@@ -158,21 +459,215 @@ public:  ////////// capacity //////////
         changeCapacity(m_size);
     }
 
+    /** Move every element into a single new region, in index order.
+     *
+     * Each element is move constructed (with its dynamic type) into one
+     * contiguous block allocated from a default constructed `Alloc` (which
+     * has to refer to a new region), then the old region is released. This
+     * restores the locality lost to `insert` and `erase`, and reclaims the
+     * memory of erased elements.
+     *
+     * If a move constructor throws, the vector is left unchanged.
+     */
+    void defragment() requires uses_region && std::default_initializable<Alloc> {
+        if (!m_data) return;
+        invalidateTypeFilters();
+
+        std::size_t bytes = 0;
+        std::size_t align = alignof(detail::ElementHeader);
+        for (size_type i = 0; i < m_size; ++i) {
+            auto const &ops = elementObjectOps(m_data[i]);
+            bytes = alignUp(bytes, detail::elementBlockAlign(ops.align)) + detail::elementBlockSize(ops);
+            align = std::max(align, detail::elementBlockAlign(ops.align));
+        }
+
+        Alloc fresh;
+        auto *block = static_cast<std::byte *>(detail::allocateBytes(fresh, bytes, align));
+        T **buf;
+        if constexpr (own_buffer)
+            buf = allocateBuffer(m_cap);
+        else {
+            BufferAlloc buffer_alloc(fresh);
+            buf = BufferTraits::allocate(buffer_alloc, m_cap + cacheSlots());
+            if constexpr (cacheSlots()) setTypeFilters(buf, m_cap, nullptr);
+        }
+        std::size_t offset = 0;
+        size_type moved = 0;
+        try {
+            for (; moved < m_size; ++moved) {
+                T *src = m_data[moved];
+                void *from = detail::mostDerived(src);
+                auto const &ops = elementObjectOps(src);
+                assert((ops.move && "cannot move element"));
+                offset = alignUp(offset, detail::elementBlockAlign(ops.align));
+                void *to = block + offset + detail::elementOffset(ops.align);
+                ::new (static_cast<void *>(detail::elementHeader(to))) detail::ElementHeader {&ops};
+                ops.move(from, to);
+                buf[moved] = detail::rebase(src, from, to);
+                offset += detail::elementBlockSize(ops);
+            }
+        } catch (...) {
+            for (size_type i = 0; i < moved; ++i) {
+                void *obj = detail::mostDerived(buf[i]);
+                detail::elementHeader(obj)->ops->destroy(obj);
+            }
+            if constexpr (own_buffer) deallocateBuffer(buf, m_cap);
+            throw;
+        }
+
+        for (size_type i = 0; i < m_size; ++i) {
+            void *obj = detail::mostDerived(m_data[i]);
+            detail::elementHeader(obj)->ops->destroy(obj);
+        }
+        // Individual deallocations are no-ops, if the old region is still
+        // shared it is freed along with the last allocator referring to it
+        m_alloc.try_release();
+        m_alloc = fresh;
+        if constexpr (own_buffer) deallocateBuffer(m_data, m_cap);
+        m_data = buf;
+    }
+
 public:  ////////// modifiers //////////
+    /** With a region allocator (see `ArenaPtrVec`), if none of the elements
+     *  need destroying, the whole region is freed at once instead.
+     */
     void clear() {
-        for (size_type i = 0; i < m_size; ++i)
-            delete m_data[i];
+        invalidateTypeFilters();
+        if (m_size && tryReleaseRegion()) {
+            replaceReleasedBuffer();
+            return;
+        }
+        deleteElements(m_data, m_size);
         m_size = 0;
+        if constexpr (uses_region) m_needs_destroy = false;
     }
 
-    iterator insert(const_iterator pos, std::unique_ptr<T> t) {
+    /** Like `clear`, but destroys the elements on up to `threads` threads
+     *  (0 means `std::thread::hardware_concurrency()`).
+     *
+     * The destructors of different elements have to be safe to run
+     * concurrently. With a region allocator the elements are only destroyed
+     * in parallel and the region is then freed at once.
+     */
+    void clear_parallel(std::size_t threads = 0) requires uses_new || uses_region {
+        invalidateTypeFilters();
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        // Not worth a thread for fewer elements than this
+        constexpr size_type min_per_thread = 4096;
+        threads = std::min(threads, m_size / min_per_thread);
+        bool needs_destroy = true;
+        if constexpr (uses_region) needs_destroy = m_needs_destroy;
+        if (threads <= 1 || !needs_destroy) {
+            clear();
+            return;
+        }
+
+        auto const chunk = (m_size + threads - 1) / threads;
+        auto destroyChunk = [this, chunk](size_type t) {
+            auto const last = std::min(m_size, (t + 1) * chunk);
+            for (size_type i = t * chunk; i < last; ++i)
+                destroyElement(m_data[i]);
+        };
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(threads - 1);
+            for (size_type t = 1; t < threads; ++t) {
+                try {
+                    workers.emplace_back(destroyChunk, t);
+                } catch (...) {
+                    destroyChunk(t);
+                }
+            }
+            destroyChunk(0);
+        }
+        m_size = 0;
+        if constexpr (uses_region) {
+            m_needs_destroy = false;
+            if (tryReleaseRegion()) replaceReleasedBuffer();
+        }
+    }
+
+    /** Like `clear`, but frees the elements in ascending address order
+     *  rather than index order, which lets the allocator coalesce neighbouring
+     *  blocks as it goes. Sorts the pointer buffer in place, so it needs no
+     *  extra memory.
+     */
+    void clear_address_ordered() {
+        invalidateTypeFilters();
+        if (m_size && tryReleaseRegion()) {
+            replaceReleasedBuffer();
+            return;
+        }
+        std::sort(m_data, m_data + m_size, std::less<T *>());
+        clear();
+    }
+
+    iterator insert(const_iterator pos, std::unique_ptr<T> t) requires uses_new {
         return insertImpl(pos, t.release());
     }
 
     template<detail::DerivedOrEqualTo<T> U>
     iterator insert(const_iterator pos, U &&t) {
         using Ctor = std::remove_cvref_t<U>;
-        return insertImpl(pos, new Ctor(std::forward<U>(t)));
+        return insertImpl(pos, newElement<Ctor>(std::forward<U>(t)));
+    }
+
+    /** Insert copies of (or, through move iterators, elements moved from) the
+     *  elements in [first, last) before `pos`.
+     *
+     * The capacity grows at most once and the tail is moved once.
+     */
+    template<std::input_iterator It, std::sentinel_for<It> S>
+    iterator insert(const_iterator pos, It first, S last)  //
+        requires(std::forward_iterator<It> || std::sized_sentinel_for<S, It>)
+        && detail::DerivedOrEqualTo<std::iter_value_t<It>, T> {
+
+        using Ctor = std::remove_cvref_t<std::iter_value_t<It>>;
+        auto const idx = size_type(detail::distance(m_data, pos));
+        auto const count = size_type(std::ranges::distance(first, last));
+        if (!count) return m_data + idx;
+        openGap(idx, count);
+        fillGap(idx, count, [&](size_type) {
+            T *ptr = newElement<Ctor>(*first);
+            ++first;
+            return ptr;
+        });
+        return m_data + idx;
+    }
+
+    /// Append copies of the elements of `range`, see `insert`
+    template<std::ranges::forward_range R>
+    void append_range(R &&range) requires detail::DerivedOrEqualTo<std::ranges::range_value_t<R>, T> {
+        insert(end(), std::ranges::begin(range), std::ranges::end(range));
+    }
+
+    /** Move all elements of `other` before `pos`, leaving `other` empty.
+     *
+     * Only the pointers are transferred, with a single copy, so no element is
+     * allocated or moved. If the allocators compare unequal, each element is
+     * moved into memory from this vector's allocator instead.
+     */
+    iterator splice(const_iterator pos, OwnPtrVec &&other) {
+        assert(&other != this);
+        auto const idx = size_type(detail::distance(m_data, pos));
+        auto const count = other.m_size;
+        if (!count) return m_data + idx;
+        openGap(idx, count);
+        if constexpr (!uses_new) {
+            if (!AllocTraits::is_always_equal::value && m_alloc != other.m_alloc) {
+                fillGap(idx, count, [&](size_type i) { return moveElementFrom(other.m_data[i]); });
+                other.clear();
+                return m_data + idx;
+            }
+        }
+        std::memcpy(m_data + idx, other.m_data, count * sizeof(T *));
+        other.m_size = 0;
+        other.invalidateTypeFilters();
+        if constexpr (uses_region) {
+            m_needs_destroy = m_needs_destroy || other.m_needs_destroy;
+            other.m_needs_destroy = false;
+        }
+        return m_data + idx;
     }
 
     iterator erase(iterator pos) {
@@ -191,8 +686,8 @@ public:  ////////// modifiers //////////
         assert(range_size > 0);
         assert(size_type(range_size) <= m_size);
         auto const start_idx = detail::distance(m_data, first);
-        for (auto i = start_idx; i < start_idx + range_size; ++i)
-            delete m_data[i];
+        invalidateTypeFilters();
+        deleteElements(m_data + start_idx, size_type(range_size));
 
         std::memmove(m_data + start_idx,
             m_data + start_idx + range_size,
@@ -201,13 +696,86 @@ public:  ////////// modifiers //////////
         return m_data + start_idx;
     }
 
+    /** Sort the elements by `comp(proj(a), proj(b))`, keeping the order of
+     *  equivalent elements.
+     *
+     * The keys are projected once per element into a contiguous array which
+     * is sorted instead of the pointers, so comparisons don't dereference the
+     * elements. Integral keys compared with `std::less` or `std::greater` are
+     * radix sorted.
+     */
+    template<typename Proj, typename Comp = std::less<>>
+    void sort_by_key(Proj proj, Comp comp = {}) {
+        invalidateTypeFilters();
+        detail::sortByKey(m_data, m_size, proj, comp);
+    }
+
+    /** Like `std::partial_sort` with the keys of `sort_by_key`: only the first
+     *  `count` elements end up sorted.
+     *
+     * Every element is still projected once, but only the best `count` keys
+     * are kept at a time, so memory use is proportional to `count`. The other
+     * elements keep their relative order.
+     */
+    template<typename Proj, typename Comp = std::less<>>
+    void partial_sort_by_key(size_type count, Proj proj, Comp comp = {}) {
+        assert(count <= m_size);
+        invalidateTypeFilters();
+        detail::partialSortByKey(m_data, m_size, count, proj, comp);
+    }
+
+    /// Like `std::nth_element` with the keys of `sort_by_key`
+    template<typename Proj, typename Comp = std::less<>>
+    void nth_element_by_key(size_type nth, Proj proj, Comp comp = {}) {
+        assert(nth < m_size);
+        invalidateTypeFilters();
+        detail::nthElementByKey(m_data, m_size, nth, proj, comp);
+    }
+
+    /** Erase every element for which `pred` returns false, keeping the order
+     *  of the rest, in a single pass. Returns the number of erased elements.
+     *
+     * `pred` is called with a reference to each element (or with the pointer,
+     * if it does not accept a reference). With a deferring allocator the
+     * erased elements are handed over in a single batch.
+     */
+    template<typename Pred>
+    size_type retain(Pred pred) {
+        invalidateTypeFilters();
+        size_type kept = 0;
+        size_type i = 0;
+        try {
+            for (; i < m_size; ++i) {
+                if (detail::invokeOnElement(pred, m_data[i])) {
+                    // When deferring, the erased elements collect in [kept, i) and are handed over at once
+                    if constexpr (defers)
+                        std::swap(m_data[kept++], m_data[i]);
+                    else
+                        m_data[kept++] = m_data[i];
+                } else if constexpr (!defers)
+                    deleteElement(m_data[i]);
+            }
+        } catch (...) {
+            if constexpr (defers) deleteElements(m_data + kept, i - kept);
+            // Close the gap so that the unvisited elements are kept
+            std::memmove(m_data + kept, m_data + i, (m_size - i) * sizeof(T *));
+            m_size = kept + (m_size - i);
+            throw;
+        }
+        if constexpr (defers) deleteElements(m_data + kept, m_size - kept);
+        auto const erased = m_size - kept;
+        m_size = kept;
+        return erased;
+    }
+
     template<detail::DerivedOrEqualTo<T> U = T, typename... Args>
     iterator emplace(const_iterator pos, Args &&...t) {
         using Ctor = std::remove_cvref_t<U>;
-        return insertImpl(pos, new Ctor(std::forward<Args>(t)...));
+        return insertImpl(pos, newElement<Ctor>(std::forward<Args>(t)...));
     }
 
-    void push_back(std::unique_ptr<T> t) {
+    void push_back(std::unique_ptr<T> t) requires uses_new {
+        invalidateTypeFilters();
         ensureExtraCapacity(1);
         m_data[m_size++] = t.release();
     }
@@ -215,87 +783,168 @@ public:  ////////// modifiers //////////
     template<detail::DerivedOrEqualTo<T> U>
     void push_back(U &&t) {
         using Ctor = std::remove_cvref_t<U>;
+        invalidateTypeFilters();
         ensureExtraCapacity(1);
-        m_data[m_size++] = new Ctor(std::forward<U>(t));
+        m_data[m_size] = newElement<Ctor>(std::forward<U>(t));
+        ++m_size;
     }
 
     /// Construct new item in-place
     template<detail::DerivedOrEqualTo<T> U = T, typename... Args>
     reference emplace_back(Args &&...args) {
         using Ctor = std::remove_cvref_t<U>;
+        invalidateTypeFilters();
         ensureExtraCapacity(1);
-        return m_data[m_size++] = new Ctor(std::forward<Args>(args)...);
+        m_data[m_size] = newElement<Ctor>(std::forward<Args>(args)...);
+        return m_data[m_size++];
     }
 
     void pop_back() {
-        delete m_data[--m_size];
+        invalidateTypeFilters();
+        deleteElement(m_data[--m_size]);
     }
 
+    /// NOTE: if `Alloc` does not propagate on swap, the allocators have to compare equal.
     void swap(OwnPtrVec &other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value)
+            std::swap(m_alloc, other.m_alloc);
+        else
+            assert((AllocTraits::is_always_equal::value || m_alloc == other.m_alloc));
         std::swap(m_data, other.m_data);
         std::swap(m_size, other.m_size);
         std::swap(m_cap, other.m_cap);
+        std::swap(m_needs_destroy, other.m_needs_destroy);
     }
 
 private:
+    template<typename Derived>
+    detail::TypeIndices collectTypeIndices() const {
+        auto indices = std::make_shared<std::vector<size_type>>();
+        for (size_type i = 0; i < m_size; ++i)
+            if (dynamic_cast<Derived const *>(m_data[i])) indices->push_back(i);
+        return indices;
+    }
+
+    /** With a polymorphic `T`, every buffer has one more slot past its
+     *  capacity, which holds the `view_of` cache (or `nullptr`).
+     *
+     * Keeping it in the buffer rather than in a member leaves the vector three
+     * words large, and a member would need `T` to be complete to decide
+     * whether it is needed.
+     */
+    static constexpr size_type cacheSlots() {
+        return std::is_polymorphic_v<T> ? 1 : 0;
+    }
+
+    static detail::TypeFilterCache *typeFilters(T *const *buf, size_type cap) {
+        static_assert(sizeof(detail::TypeFilterCache *) == sizeof(T *));
+        detail::TypeFilterCache *cache;
+        std::memcpy(&cache, buf + cap, sizeof(cache));
+        return cache;
+    }
+
+    static void setTypeFilters(T **buf, size_type cap, detail::TypeFilterCache *cache) {
+        std::memcpy(buf + cap, &cache, sizeof(cache));
+    }
+
+    /// Drop the `view_of` cache, called by every modification
+    void invalidateTypeFilters() noexcept {
+        if constexpr (std::is_polymorphic_v<T>) {
+            if (!m_data) return;
+            if (auto *cache = typeFilters(m_data, m_cap)) {
+                delete cache;
+                setTypeFilters(m_data, m_cap, nullptr);
+            }
+        }
+    }
+
     void deleteData() {
+        invalidateTypeFilters();
         if (!m_data) {
             assert(!m_cap);
             assert(!m_size);
             return;
         }
-        clear();
-        delete[] m_data;
+        if (!tryReleaseRegion()) {
+            clear();
+            deallocateBuffer(m_data, m_cap);
+        } else if constexpr (own_buffer)
+            deallocateBuffer(m_data, m_cap);
         m_data = nullptr;
         m_size = 0;
         m_cap = 0;
     }
 
+    /** Free all elements (and the buffer, unless `Buffer` manages it) at once
+     *  if the allocator allows it.
+     *
+     * `m_data` is left dangling if successful, see `replaceReleasedBuffer`.
+     */
+    bool tryReleaseRegion() {
+        if constexpr (uses_region) {
+            invalidateTypeFilters();
+            if (!m_needs_destroy && m_alloc.try_release()) {
+                m_size = 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Give an empty (moved-from) vector a region of its own.
+     *
+     * Moving a region allocator copies it, so the vector would otherwise keep
+     * sharing the region it was moved into, which could then never be
+     * released at once.
+     */
+    void detachRegion() {
+        assert(!m_data);
+        if constexpr (uses_region && std::default_initializable<Alloc>) m_alloc = Alloc();
+    }
+
+    /// After `tryReleaseRegion` succeeded, allocate a buffer with the same capacity again if it was freed
+    void replaceReleasedBuffer() {
+        if constexpr (!own_buffer) m_data = allocateBuffer(m_cap);
+    }
+
     void changeCapacity(size_type to) {
         if (to == m_cap) return;
-        auto *tmp = new T *[to]();
         assert(to >= m_size);
+        if constexpr (own_buffer) {
+            if (m_data) {
+                invalidateTypeFilters();
+                m_data = static_cast<T **>(Buffer::reallocate(m_data, bufferBytes(m_cap), bufferBytes(to)));
+                m_cap = to;
+                if constexpr (cacheSlots()) setTypeFilters(m_data, m_cap, nullptr);
+                return;
+            }
+        }
+        auto *tmp = allocateBuffer(to);
         if (m_size) {
             assert(m_data);
             std::memcpy(tmp, m_data, sizeof(T *) * m_size);
         }
-        m_cap = to;
         std::swap(m_data, tmp);
-        delete[] tmp;
+        deallocateBuffer(tmp, m_cap);
+        m_cap = to;
     }
 
     void ensureExtraCapacity(size_type elems) {
-        auto new_cap = calcCapacity(m_cap, m_size + elems);
-        if (m_cap > new_cap) return;
-        changeCapacity(new_cap);
+        if (m_size + elems <= m_cap) return;
+        changeCapacity(Growth::grow(m_cap, m_size + elems));
     }
 
     iterator insertImpl(const_iterator pos, T *t) {
-        if (pos == end()) {
-            push_back(std::unique_ptr<T> {t});
-            return end() - 1;
-        }
         auto const idx = detail::distance(m_data, pos);
         assert(idx >= 0);
-        assert(size_type(idx) <= m_size);
-        if (m_size + 1 >= m_cap) {
-            m_cap = calcCapacity(m_cap, m_size + 1);
-            auto *tmp = new T *[m_cap];
-            std::memcpy(tmp, m_data, size_type(idx) * sizeof(T *));
-            std::memcpy(tmp + idx + 1, m_data + idx, (m_size - size_type(idx)) * sizeof(T *));
-            std::swap(m_data, tmp);
-            delete[] tmp;
-        } else
-            std::memmove(m_data + idx + 1, m_data + idx, (m_size - size_type(idx)) * sizeof(T *));
-
-        ++m_size;
+        openGap(size_type(idx), 1);
         m_data[idx] = t;
         return m_data + idx;
     }
 
     template<detail::UniquePtr First, typename... Args>
     void makeImpl(First &&first, Args &&...args)  //
-        requires detail::DerivedOrEqualTo<typename First::element_type, T> {
+        requires uses_new && detail::DerivedOrEqualTo<typename First::element_type, T> {
 
         m_data[m_size++] = first.release();
         if constexpr (sizeof...(Args)) makeImpl(std::forward<Args>(args)...);
@@ -306,42 +955,252 @@ private:
         requires detail::DerivedOrEqualTo<First, T> {
 
         using Ctor = std::remove_cvref_t<First>;
-        m_data[m_size++] = new Ctor(std::forward<First>(first));
+        m_data[m_size++] = newElement<Ctor>(std::forward<First>(first));
         if constexpr (sizeof...(Args)) makeImpl(std::forward<Args>(args)...);
     }
 
-    [[nodiscard]]
-    static constexpr size_type calcCapacity(size_type old, size_type new_) {
-        if (old >= new_) return new_;
-        old = old < 2 ? 2 : old;
-        for (; old < new_; old = size_type(double(old) * multiplier)) { }
-        return old;
+    /// Size of a buffer for `count` elements when it is managed by `Buffer`
+    static constexpr std::size_t bufferBytes(size_type count) {
+        return (count + cacheSlots()) * sizeof(T *);
+    }
+
+    /// The element slots are left uninitialised; only the first `m_size` of them are ever read
+    T **allocateBuffer(size_type count) {
+        T **buf;
+        if constexpr (own_buffer)
+            buf = static_cast<T **>(Buffer::allocate(bufferBytes(count)));
+        else if constexpr (uses_new)
+            buf = new T *[count + cacheSlots()];
+        else {
+            BufferAlloc alloc(m_alloc);
+            buf = BufferTraits::allocate(alloc, count + cacheSlots());
+        }
+        if constexpr (cacheSlots()) setTypeFilters(buf, count, nullptr);
+        return buf;
+    }
+
+    void deallocateBuffer(T **buf, size_type count) {
+        if (!buf) return;
+        if constexpr (cacheSlots()) delete typeFilters(buf, count);
+        if constexpr (own_buffer)
+            Buffer::deallocate(buf, bufferBytes(count));
+        else if constexpr (uses_new)
+            delete[] buf;
+        else {
+            BufferAlloc alloc(m_alloc);
+            BufferTraits::deallocate(alloc, buf, count + cacheSlots());
+        }
+    }
+
+    template<typename U, typename... Args>
+    T *newElement(Args &&...args) {
+        if constexpr (uses_region) m_needs_destroy = m_needs_destroy || !std::is_trivially_destructible_v<U>;
+        if constexpr (uses_new) {
+            detail::registerObjectOps<U>();
+            return new U(std::forward<Args>(args)...);
+        } else {
+            static_assert(detail::BytesAllocator<Alloc> || alignof(U) <= detail::max_element_align);
+            void *storage = detail::allocateElement(m_alloc, detail::objectOps<U>);
+            U *obj;
+            try {
+                obj = ::new (storage) U(std::forward<Args>(args)...);
+            } catch (...) {
+                detail::deallocateElement(m_alloc, storage);
+                throw;
+            }
+            T *ptr = obj;
+            assert(detail::mostDerived(ptr) == storage);
+            return ptr;
+        }
+    }
+
+    void deleteElement(T *ptr) noexcept {
+        if constexpr (defers)
+            m_alloc.defer(&ptr, 1);
+        else if constexpr (uses_new)
+            delete ptr;
+        else {
+            void *obj = detail::mostDerived(ptr);
+            detail::elementHeader(obj)->ops->destroy(obj);
+            detail::deallocateElement(m_alloc, obj);
+        }
+    }
+
+    void deleteElements(T *const *ptrs, size_type count) noexcept {
+        if constexpr (defers)
+            m_alloc.defer(ptrs, count);
+        else
+            for (size_type i = 0; i < count; ++i)
+                deleteElement(ptrs[i]);
+    }
+
+    /// Destroy the element at `ptr`, but only free its memory if that does not go through `m_alloc`
+    void destroyElement(T *ptr) const noexcept requires uses_new || uses_region {
+        if constexpr (uses_new)
+            delete ptr;
+        else {
+            void *obj = detail::mostDerived(ptr);
+            detail::elementHeader(obj)->ops->destroy(obj);
+        }
+    }
+
+    static constexpr std::size_t alignUp(std::size_t offset, std::size_t align) {
+        return (offset + align - 1) / align * align;
+    }
+
+    /** Type erased operations of the dynamic type of the element `ptr`.
+     *
+     * With the default allocator they are looked up by `typeid`, which throws
+     * `UnknownDynamicTypeError` if the type was never registered.
+     */
+    static detail::ObjectOps const &elementObjectOps(T const *ptr) {
+        if constexpr (uses_new) {
+            auto const *ops = detail::dynamicObjectOps(*ptr);
+            if (!ops) throw UnknownDynamicTypeError(typeid(*ptr));
+            return *ops;
+        } else
+            return *detail::elementHeader(detail::mostDerived(ptr))->ops;
+    }
+
+    /// Move every element of `other` into memory owned by this vector's allocator
+    void relocateFrom(OwnPtrVec &other) requires(!uses_new) {
+        assert(!m_data);
+        m_data = allocateBuffer(other.m_size);
+        m_cap = other.m_size;
+        m_needs_destroy = other.m_needs_destroy;
+        for (; m_size < other.m_size; ++m_size)
+            m_data[m_size] = moveElementFrom(other.m_data[m_size]);
+        other.deleteData();
+    }
+
+    /// Move construct the element at `src` (owned by another vector) into memory from this vector's allocator
+    T *moveElementFrom(T *src) requires(!uses_new) {
+        void *from = detail::mostDerived(src);
+        auto const &ops = *detail::elementHeader(from)->ops;
+        assert((ops.move && "cannot move element between allocators"));
+        void *to = detail::allocateElement(m_alloc, ops);
+        try {
+            ops.move(from, to);
+        } catch (...) {
+            detail::deallocateElement(m_alloc, to);
+            throw;
+        }
+        if constexpr (uses_region) m_needs_destroy = m_needs_destroy || !ops.trivially_destructible;
+        return detail::rebase(src, from, to);
+    }
+
+    /** Make room for `count` elements at `idx`, growing the capacity at most
+     *  once and moving the tail once. The new slots are uninitialised.
+     */
+    void openGap(size_type idx, size_type count) {
+        assert(idx <= m_size);
+        invalidateTypeFilters();
+        if (m_size + count > m_cap && !own_buffer) {
+            auto const new_cap = Growth::grow(m_cap, m_size + count);
+            auto *tmp = allocateBuffer(new_cap);
+            if (m_size) {
+                std::memcpy(tmp, m_data, idx * sizeof(T *));
+                std::memcpy(tmp + idx + count, m_data + idx, (m_size - idx) * sizeof(T *));
+            }
+            std::swap(m_data, tmp);
+            deallocateBuffer(tmp, m_cap);
+            m_cap = new_cap;
+            m_size += count;
+            return;
+        }
+        ensureExtraCapacity(count);
+        if (idx != m_size) std::memmove(m_data + idx + count, m_data + idx, (m_size - idx) * sizeof(T *));
+        m_size += count;
+    }
+
+    /// Undo `openGap`
+    void closeGap(size_type idx, size_type count) noexcept {
+        std::memmove(m_data + idx, m_data + idx + count, (m_size - idx - count) * sizeof(T *));
+        m_size -= count;
+    }
+
+    /** Fill the `count` slots at `idx` (opened by `openGap`) with `make(i)`.
+     *
+     * If `make` throws, the elements made so far are deleted and the gap is closed.
+     */
+    template<typename Make>
+    void fillGap(size_type idx, size_type count, Make &&make) {
+        size_type done = 0;
+        try {
+            for (; done < count; ++done)
+                m_data[idx + done] = make(done);
+        } catch (...) {
+            for (size_type i = 0; i < done; ++i)
+                deleteElement(m_data[idx + i]);
+            closeGap(idx, count);
+            throw;
+        }
     }
 
 #undef BASE
 };
 
-template<typename T>
-using OwnPtrStack = std::stack<T, OwnPtrVec<T>>;
+template<typename T,
+    typename Alloc = std::allocator<T>,
+    GrowthPolicy Growth = GeometricGrowth<>,
+    BufferPolicy Buffer = AllocatorBuffer>
+using OwnPtrStack = std::stack<T, OwnPtrVec<T, Alloc, Growth, Buffer>>;
 
+/** An `OwnPtrVec` whose elements are bump-allocated out of a region owned by the vector.
+ *
+ * If none of the stored elements need destroying (all of their dynamic types
+ * are trivially destructible), `clear()` and the destructor free the whole
+ * region in one step instead of visiting every element.
+ *
+ * NOTE: erased elements are not reclaimed until the region is freed.
+ */
 template<typename T>
-struct IsComparableContainerBase<OwnPtrVec<T>, PtrVecView<T>> : std::true_type { };
+using ArenaPtrVec = OwnPtrVec<T, ArenaAllocator<T>>;
 
-template<typename T>
-struct IsComparableContainerBase<PtrVecView<T>, OwnPtrVec<T>> : std::true_type { };
+template<typename T,
+    typename AllocA,
+    typename GrowthA,
+    typename BufferA,
+    typename AllocB,
+    typename GrowthB,
+    typename BufferB>
+requires(!std::same_as<OwnPtrVec<T, AllocA, GrowthA, BufferA>, OwnPtrVec<T, AllocB, GrowthB, BufferB>>)  //
+struct IsComparableContainerBase<OwnPtrVec<T, AllocA, GrowthA, BufferA>, OwnPtrVec<T, AllocB, GrowthB, BufferB>>
+        : std::true_type { };
 
-template<typename T>
-void swap(ut::OwnPtrVec<T> &a, ut::OwnPtrVec<T> &b) {
+template<typename T, typename Alloc, typename Growth, typename Buffer>
+struct IsComparableContainerBase<OwnPtrVec<T, Alloc, Growth, Buffer>, PtrVecView<T>> : std::true_type { };
+
+template<typename T, typename Alloc, typename Growth, typename Buffer>
+struct IsComparableContainerBase<PtrVecView<T>, OwnPtrVec<T, Alloc, Growth, Buffer>> : std::true_type { };
+
+/// Erase the elements for which `pred` returns true in a single pass, see `OwnPtrVec::retain`
+template<typename T, typename Alloc, typename Growth, typename Buffer, typename Pred>
+typename OwnPtrVec<T, Alloc, Growth, Buffer>::size_type erase_if(OwnPtrVec<T, Alloc, Growth, Buffer> &vec, Pred pred) {
+    return vec.retain([&pred](auto &&elem) { return !detail::invokeOnElement(pred, std::addressof(elem)); });
+}
+
+/** This overload is called in ADL use of swap
+ *
+ * NOTE: there is no `std::swap` overload, as `std` is an associated namespace
+ *       of `std::allocator` and the two would be ambiguous.
+ */
+template<typename T, typename Alloc, typename Growth, typename Buffer>
+void swap(ut::OwnPtrVec<T, Alloc, Growth, Buffer> &a, ut::OwnPtrVec<T, Alloc, Growth, Buffer> &b) {
     a.swap(b);
 }
 
 }  // namespace ut
 
 namespace std {
-template<typename T>
-void swap(ut::OwnPtrVec<T> &a, ut::OwnPtrVec<T> &b) {
-    a.swap(b);
-}
-}
+/// Hashes the elements, not the pointers. Equal to the hash of an equal `ut::PtrVecView`.
+template<typename T, typename Alloc, typename Growth, typename Buffer>
+requires ut::detail::Hashable<T>
+struct hash<ut::OwnPtrVec<T, Alloc, Growth, Buffer>> {
+    std::size_t operator()(ut::OwnPtrVec<T, Alloc, Growth, Buffer> const &v) const {
+        return ut::detail::hashElements(v.data(), v.size());
+    }
+};
+}  // namespace std
 
 #endif  // OWNPTRVEC_HPP
@@ -0,0 +1,383 @@
+#ifndef POLYCOLLECTION_HPP
+#define POLYCOLLECTION_HPP
+
+#include "container_base.hpp"
+#include "growth.hpp"
+#include "object_ops.hpp"
+#include "ptrvecview.hpp"
+#include "template_helpers.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace ut {
+
+namespace detail {
+    /// Contiguous storage for all objects of a single dynamic type in a `PolyCollection`
+    struct PolySegment {
+        std::type_info const *type;
+        ObjectOps const *ops;
+        /// Offset of the base class subobject from the start of each object
+        std::ptrdiff_t base_offset = 0;
+        std::byte *data = nullptr;
+        std::size_t size = 0;
+        std::size_t cap = 0;
+        /// Position in the collection of each object of the segment
+        std::vector<std::size_t> index;
+
+        PolySegment(std::type_info const &type_, ObjectOps const &ops_)
+                : type(&type_)
+                , ops(&ops_) { }
+
+        void *slot(std::size_t i) const {
+            return data + i * ops->size;
+        }
+
+        /// Find the slot of the object at `obj`, or `npos` if it is not in this segment
+        std::size_t find(void const *obj) const {
+            auto const *ptr = static_cast<std::byte const *>(obj);
+            if (ptr < data || ptr >= data + size * ops->size) return npos;
+            return std::size_t(ptr - data) / ops->size;
+        }
+
+        /// Move all objects into a new buffer of `new_cap` slots
+        void relocate(std::size_t new_cap) {
+            assert(new_cap >= size);
+            index.reserve(new_cap);
+            auto *tmp = static_cast<std::byte *>(::operator new(new_cap * ops->size, std::align_val_t(ops->align)));
+            if (ops->trivially_copyable) {
+                if (size) std::memcpy(tmp, data, size * ops->size);
+            } else
+                for (std::size_t i = 0; i < size; ++i) {
+                    ops->move(slot(i), tmp + i * ops->size);
+                    ops->destroy(slot(i));
+                }
+            deallocate();
+            data = tmp;
+            cap = new_cap;
+        }
+
+        /// Destroy the object in slot `i` and move the last object into it
+        void erase(std::size_t i) noexcept {
+            assert(i < size);
+            ops->destroy(slot(i));
+            if (--size != i) {
+                ops->move(slot(size), slot(i));
+                ops->destroy(slot(size));
+                index[i] = index[size];
+            }
+            index.pop_back();
+        }
+
+        void clear() noexcept {
+            if (!ops->trivially_destructible)
+                for (std::size_t i = 0; i < size; ++i)
+                    ops->destroy(slot(i));
+            size = 0;
+            index.clear();
+        }
+
+        void deallocate() noexcept {
+            if (data) ::operator delete(data, std::align_val_t(ops->align));
+            data = nullptr;
+        }
+
+        static constexpr std::size_t npos = ~std::size_t(0);
+    };
+}  // namespace detail
+
+#define BASE                                 \
+    ContainerBase<T,                         \
+        /*ValueType      = */ T,             \
+        /*StorageType    = */ T **,          \
+        /*Reference      = */ T *,           \
+        /*ConstReference = */ T const *,     \
+        /*Iterator       = */ T **,          \
+        /*ConstIterator  = */ T *const *>
+
+/** A collection of objects derived from `T`, grouped by their dynamic type.
+ *
+ * All objects of the same dynamic type are stored by value in one contiguous
+ * segment, instead of being allocated separately. Iterating over a segment
+ * (see `segment` and `for_each`) therefore touches memory sequentially and
+ * calls the same virtual function implementations in a row.
+ *
+ * The collection also keeps an index of pointers in insertion order, which
+ * provides the same (read) API as `OwnPtrVec`.
+ *
+ * NOTE: Objects move when their segment grows or when an object of the same
+ *       type is erased, so pointers to elements are invalidated by any
+ *       modification. The order of objects within a segment is unspecified.
+ *       Stored types have to be nothrow move constructible.
+ */
+template<typename T>
+class PolyCollection : public BASE {
+    using Base = BASE;
+#undef BASE
+
+    UT_CONTAINER_BASE_INJECT_DEPENDANT_NAMES(Base);
+
+private:
+    size_type m_cap = 0;
+    std::vector<detail::PolySegment> m_segments;
+
+public:  ////////// constructors //////////
+    PolyCollection() {
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    PolyCollection(PolyCollection const &) = delete;
+    PolyCollection &operator=(PolyCollection const &) = delete;
+
+    PolyCollection(PolyCollection &&other) noexcept
+            : m_cap(std::exchange(other.m_cap, 0))
+            , m_segments(std::move(other.m_segments)) {
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    PolyCollection &operator=(PolyCollection &&other) noexcept {
+        PolyCollection tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    ~PolyCollection() {
+        static_assert(sizeof(T) >= 0, "Cannot have incomplete type in the constructor");
+        clear();
+        for (auto &seg : m_segments)
+            seg.deallocate();
+        delete[] m_data;
+    }
+
+    /// Create a (non-owning) view of the collection, in insertion order
+    PtrVecView<T> view() const {
+        return PtrVecView<T>(begin(), m_size);
+    }
+
+public:  ////////// segments //////////
+
+    /// All objects whose dynamic type is `U` (in unspecified order)
+    template<detail::DerivedOrEqualTo<T> U>
+    std::span<U> segment() {
+        auto *seg = findSegment(typeid(U));
+        if (!seg || !seg->size) return {};
+        return std::span<U>(std::launder(reinterpret_cast<U *>(seg->data)), seg->size);
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    std::span<U const> segment() const {
+        return const_cast<PolyCollection *>(this)->template segment<U>();
+    }
+
+    /// Number of distinct dynamic types which have been stored
+    size_type segment_count() const {
+        return m_segments.size();
+    }
+
+    /// Make room for `count` objects of type `U` without reallocating its segment
+    template<detail::DerivedOrEqualTo<T> U>
+    void segment_reserve(size_type count) {
+        auto &seg = segmentFor<U>();
+        if (count > seg.cap) relocate(seg, count);
+    }
+
+    /** Call `f` on every object, one segment at a time.
+     *
+     * Objects whose dynamic type is one of `Us` are passed as `U &`, so calls
+     * to its member functions can be resolved statically. All other objects
+     * are passed as `T &`.
+     */
+    template<typename... Us, typename F>
+    void for_each(F &&f) {
+        static_assert((detail::DerivedOrEqualTo<Us, T> && ...));
+        for (auto &seg : m_segments) {
+            if ((visitSegment<Us>(seg, f) || ...)) continue;
+            for (size_type i = 0; i < seg.size; ++i)
+                f(*elementAt(seg, i));
+        }
+    }
+
+    template<typename... Us, typename F>
+    void for_each(F &&f) const {
+        const_cast<PolyCollection *>(this)->template for_each<Us...>(
+            [&f](auto &obj) { f(std::as_const(obj)); });
+    }
+
+public:  ////////// capacity //////////
+    void reserve(size_type new_capacity) {
+        if (new_capacity <= m_cap) return;
+        changeCapacity(new_capacity);
+    }
+
+    size_type capacity() const {
+        return m_cap;
+    }
+
+public:  ////////// modifiers //////////
+    /// Segments keep their memory
+    void clear() noexcept {
+        for (auto &seg : m_segments)
+            seg.clear();
+        m_size = 0;
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    void push_back(U &&t) {
+        emplace_back<std::remove_cvref_t<U>>(std::forward<U>(t));
+    }
+
+    /// Construct new item in-place
+    template<detail::DerivedOrEqualTo<T> U = T, typename... Args>
+    reference emplace_back(Args &&...args) {
+        using Ctor = std::remove_cvref_t<U>;
+        static_assert(std::is_nothrow_move_constructible_v<Ctor>, "Objects are moved when their segment grows");
+        ensureExtraCapacity(1);
+        auto &seg = segmentFor<Ctor>();
+        if (seg.size == seg.cap) relocate(seg, GeometricGrowth<>::grow(seg.cap, seg.size + 1));
+        auto *obj = ::new (seg.slot(seg.size)) Ctor(std::forward<Args>(args)...);
+        T *ptr = obj;
+        assert(detail::mostDerived(ptr) == obj);
+        seg.base_offset = reinterpret_cast<std::byte *>(ptr) - reinterpret_cast<std::byte *>(obj);
+        seg.index.push_back(m_size);
+        ++seg.size;
+        m_data[m_size] = ptr;
+        return m_data[m_size++];
+    }
+
+    void pop_back() {
+        assert(m_size > 0);
+        erase(end() - 1);
+    }
+
+    iterator erase(iterator pos) {
+        return erase(const_iterator(pos));
+    }
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    /// NOTE: Erasing anything but the last elements is linear in the size of the collection
+    iterator erase(const_iterator first, const_iterator last) {
+        auto const start_idx = size_type(detail::distance(const_iterator(m_data), first));
+        auto const end_idx = size_type(detail::distance(const_iterator(m_data), last));
+        assert(start_idx <= end_idx);
+        assert(end_idx <= m_size);
+        if (start_idx == end_idx) return m_data + start_idx;
+
+        for (auto i = end_idx; i-- > start_idx;) {
+            void *obj = detail::mostDerived(m_data[i]);
+            auto &seg = segmentOf(obj);
+            auto const slot = seg.find(obj);
+            seg.erase(slot);
+            if (slot != seg.size) m_data[seg.index[slot]] = elementAt(seg, slot);
+        }
+
+        auto const count = end_idx - start_idx;
+        if (end_idx != m_size) {
+            std::memmove(m_data + start_idx, m_data + end_idx, (m_size - end_idx) * sizeof(T *));
+            for (auto &seg : m_segments)
+                for (auto &idx : seg.index)
+                    if (idx >= end_idx) idx -= count;
+        }
+        m_size -= count;
+        return m_data + start_idx;
+    }
+
+    void swap(PolyCollection &other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_cap, other.m_cap);
+        m_segments.swap(other.m_segments);
+    }
+
+private:
+    static T *elementAt(detail::PolySegment const &seg, size_type i) {
+        return std::launder(reinterpret_cast<T *>(static_cast<std::byte *>(seg.slot(i)) + seg.base_offset));
+    }
+
+    template<typename U, typename F>
+    static bool visitSegment(detail::PolySegment &seg, F &f) {
+        if (*seg.type != typeid(U)) return false;
+        auto *objs = std::launder(reinterpret_cast<U *>(seg.data));
+        for (size_type i = 0; i < seg.size; ++i)
+            f(objs[i]);
+        return true;
+    }
+
+    detail::PolySegment *findSegment(std::type_info const &type) {
+        for (auto &seg : m_segments)
+            if (*seg.type == type) return &seg;
+        return nullptr;
+    }
+
+    template<typename U>
+    detail::PolySegment &segmentFor() {
+        if (auto *seg = findSegment(typeid(U))) return *seg;
+        return m_segments.emplace_back(typeid(U), detail::objectOps<U>);
+    }
+
+    detail::PolySegment &segmentOf(void const *obj) {
+        for (auto &seg : m_segments)
+            if (seg.find(obj) != detail::PolySegment::npos) return seg;
+        assert((false && "object does not belong to the collection"));
+        return m_segments.front();
+    }
+
+    /// Move the objects of `seg` into a buffer of `cap` slots and update the index
+    void relocate(detail::PolySegment &seg, size_type cap) {
+        seg.relocate(cap);
+        for (size_type i = 0; i < seg.size; ++i)
+            m_data[seg.index[i]] = elementAt(seg, i);
+    }
+
+    void changeCapacity(size_type to) {
+        if (to == m_cap) return;
+        auto *tmp = new T *[to];
+        assert(to >= m_size);
+        if (m_size) std::memcpy(tmp, m_data, sizeof(T *) * m_size);
+        std::swap(m_data, tmp);
+        delete[] tmp;
+        m_cap = to;
+    }
+
+    void ensureExtraCapacity(size_type elems) {
+        if (m_size + elems <= m_cap) return;
+        changeCapacity(GeometricGrowth<>::grow(m_cap, m_size + elems));
+    }
+};
+
+template<typename T>
+struct IsComparableContainerBase<PolyCollection<T>, PtrVecView<T>> : std::true_type { };
+
+template<typename T>
+struct IsComparableContainerBase<PtrVecView<T>, PolyCollection<T>> : std::true_type { };
+
+/// This overload is called in ADL use of swap
+template<typename T>
+void swap(ut::PolyCollection<T> &a, ut::PolyCollection<T> &b) {
+    a.swap(b);
+}
+
+}  // namespace ut
+
+namespace std {
+/// This overload is called when swap is invoked as `std::swap`
+template<typename T>
+void swap(ut::PolyCollection<T> &a, ut::PolyCollection<T> &b) {
+    a.swap(b);
+}
+}
+
+#endif  // POLYCOLLECTION_HPP
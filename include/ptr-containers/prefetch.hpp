@@ -0,0 +1,154 @@
+#ifndef PREFETCH_HPP
+#define PREFETCH_HPP
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#    define UT_PREFETCH(ptr) __builtin_prefetch(static_cast<void const *>(ptr), 0, 3)
+#else
+#    define UT_PREFETCH(ptr) static_cast<void>(ptr)
+#endif
+
+namespace ut {
+
+/// How many elements ahead the pointees are prefetched by default
+inline constexpr std::size_t default_prefetch_distance = 8;
+
+namespace detail {
+    /** A random access iterator over a buffer of pointers, which prefetches
+     *  the pointee `distance` elements ahead whenever it is incremented.
+     *
+     * `Slot` is the (possibly const qualified) pointer type stored in the buffer.
+     */
+    template<typename Slot>
+    class PrefetchIterator {
+        Slot *m_pos = nullptr;
+        Slot *m_end = nullptr;
+        std::ptrdiff_t m_distance = 0;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using iterator_concept = std::random_access_iterator_tag;
+        using value_type = std::remove_cv_t<Slot>;
+        using difference_type = std::ptrdiff_t;
+        using reference = Slot &;
+        using pointer = Slot *;
+
+        PrefetchIterator() = default;
+
+        PrefetchIterator(Slot *pos, Slot *end, std::size_t distance)
+                : m_pos(pos)
+                , m_end(end)
+                , m_distance(std::ptrdiff_t(distance)) { }
+
+        /// Prefetch the pointees of the first `distance` elements
+        void prime() const {
+            for (auto *p = m_pos; p < m_end && p < m_pos + m_distance; ++p)
+                UT_PREFETCH(*p);
+        }
+
+        reference operator*() const {
+            return *m_pos;
+        }
+
+        pointer operator->() const {
+            return m_pos;
+        }
+
+        reference operator[](difference_type n) const {
+            return m_pos[n];
+        }
+
+        PrefetchIterator &operator++() {
+            ++m_pos;
+            if (m_end - m_pos > m_distance) UT_PREFETCH(m_pos[m_distance]);
+            return *this;
+        }
+
+        PrefetchIterator operator++(int) {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        PrefetchIterator &operator--() {
+            --m_pos;
+            return *this;
+        }
+
+        PrefetchIterator operator--(int) {
+            auto tmp = *this;
+            --m_pos;
+            return tmp;
+        }
+
+        PrefetchIterator &operator+=(difference_type n) {
+            m_pos += n;
+            return *this;
+        }
+
+        PrefetchIterator &operator-=(difference_type n) {
+            m_pos -= n;
+            return *this;
+        }
+
+        friend PrefetchIterator operator+(PrefetchIterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend PrefetchIterator operator+(difference_type n, PrefetchIterator it) {
+            return it += n;
+        }
+
+        friend PrefetchIterator operator-(PrefetchIterator it, difference_type n) {
+            return it -= n;
+        }
+
+        friend difference_type operator-(PrefetchIterator const &a, PrefetchIterator const &b) {
+            return a.m_pos - b.m_pos;
+        }
+
+        friend bool operator==(PrefetchIterator const &a, PrefetchIterator const &b) {
+            return a.m_pos == b.m_pos;
+        }
+
+        friend std::strong_ordering operator<=>(PrefetchIterator const &a, PrefetchIterator const &b) {
+            return std::compare_three_way()(a.m_pos, b.m_pos);
+        }
+    };
+
+    /// A range of `PrefetchIterator`s, see `ContainerBase::prefetched`
+    template<typename Slot>
+    class PrefetchRange {
+        Slot *m_begin;
+        Slot *m_end;
+        std::size_t m_distance;
+
+    public:
+        PrefetchRange(Slot *begin, Slot *end, std::size_t distance)
+                : m_begin(begin)
+                , m_end(end)
+                , m_distance(distance) { }
+
+        PrefetchIterator<Slot> begin() const {
+            PrefetchIterator<Slot> it(m_begin, m_end, m_distance);
+            it.prime();
+            return it;
+        }
+
+        PrefetchIterator<Slot> end() const {
+            return PrefetchIterator<Slot>(m_end, m_end, m_distance);
+        }
+
+        std::size_t size() const {
+            return std::size_t(m_end - m_begin);
+        }
+    };
+}  // namespace detail
+
+}  // namespace ut
+
+#endif  // PREFETCH_HPP
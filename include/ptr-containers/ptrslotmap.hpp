@@ -0,0 +1,290 @@
+#ifndef PTRSLOTMAP_HPP
+#define PTRSLOTMAP_HPP
+
+#include "container_base.hpp"
+#include "growth.hpp"
+#include "ptrvecview.hpp"
+#include "template_helpers.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ut {
+
+/** A stable reference to an element of a `PtrSlotMap`.
+ *
+ * Once the element is erased the handle becomes stale, which the map
+ * detects (even if its slot has been reused since).
+ */
+struct SlotHandle {
+    static constexpr std::uint32_t invalid = ~std::uint32_t(0);
+
+    std::uint32_t index = invalid;
+    std::uint32_t generation = 0;
+
+    friend bool operator==(SlotHandle const &, SlotHandle const &) = default;
+};
+
+#define BASE                             \
+    ContainerBase<T,                     \
+        /*ValueType      = */ T,         \
+        /*StorageType    = */ T **,      \
+        /*Reference      = */ T *,       \
+        /*ConstReference = */ T const *, \
+        /*Iterator       = */ T **,      \
+        /*ConstIterator  = */ T *const *>
+
+/** A vector of owning pointers to `T` whose elements are addressed by
+ *  generational handles (`SlotHandle`) instead of indices.
+ *
+ * The pointers are kept dense, so iterating works like with an `OwnPtrVec`,
+ * but erasing moves the last pointer into the gap (O(1)), so the order of
+ * elements is unspecified. Handles stay valid until their element is erased.
+ *
+ * Elements are created with `new` and destroyed with `delete`.
+ *
+ * NOTE: A slot's generation wraps after 2^32 reuses, after which a stale
+ *       handle to it could be mistaken for a live one.
+ */
+template<typename T>
+class PtrSlotMap : public BASE {
+    using Base = BASE;
+#undef BASE
+
+    UT_CONTAINER_BASE_INJECT_DEPENDANT_NAMES(Base);
+
+    struct Slot {
+        /// Dense index of the element if the slot is in use, otherwise the next free slot
+        std::uint32_t index;
+        /// Incremented whenever the slot's element is erased
+        std::uint32_t generation;
+    };
+
+    size_type m_cap = 0;
+    /// Slot of each element, parallel to `m_data`
+    std::vector<std::uint32_t> m_dense_slot;
+    std::vector<Slot> m_slots;
+    std::uint32_t m_free = SlotHandle::invalid;
+
+public:  ////////// constructors //////////
+    PtrSlotMap() {
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    PtrSlotMap(PtrSlotMap const &) = delete;
+    PtrSlotMap &operator=(PtrSlotMap const &) = delete;
+
+    PtrSlotMap(PtrSlotMap &&other) noexcept
+            : m_cap(std::exchange(other.m_cap, 0))
+            , m_dense_slot(std::move(other.m_dense_slot))
+            , m_slots(std::move(other.m_slots))
+            , m_free(std::exchange(other.m_free, SlotHandle::invalid)) {
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    PtrSlotMap &operator=(PtrSlotMap &&other) noexcept {
+        PtrSlotMap tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    ~PtrSlotMap() {
+        static_assert(sizeof(T) >= 0, "Cannot have incomplete type in the constructor");
+        for (size_type i = 0; i < m_size; ++i)
+            delete m_data[i];
+        delete[] m_data;
+    }
+
+    /// Create a (non-owning) view of the elements, in dense order
+    PtrVecView<T> view() const {
+        return PtrVecView<T>(begin(), m_size);
+    }
+
+public:  ////////// handles //////////
+
+    /// The element referred to by `handle`, or `nullptr` if it was erased
+    T *get(SlotHandle handle) {
+        return contains(handle) ? m_data[m_slots[handle.index].index] : nullptr;
+    }
+
+    T const *get(SlotHandle handle) const {
+        return contains(handle) ? m_data[m_slots[handle.index].index] : nullptr;
+    }
+
+    bool contains(SlotHandle handle) const {
+        return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation;
+    }
+
+    /// Handle of the element at dense index `idx`
+    SlotHandle handle_of(size_type idx) const {
+        assert(idx < m_size);
+        auto const slot = m_dense_slot[idx];
+        return {slot, m_slots[slot].generation};
+    }
+
+    SlotHandle handle_of(const_iterator pos) const {
+        return handle_of(size_type(detail::distance(const_iterator(m_data), pos)));
+    }
+
+public:  ////////// capacity //////////
+    void reserve(size_type new_capacity) {
+        if (new_capacity > m_cap) changeCapacity(new_capacity);
+        m_dense_slot.reserve(new_capacity);
+        m_slots.reserve(new_capacity);
+    }
+
+    size_type capacity() const {
+        return m_cap;
+    }
+
+public:  ////////// modifiers //////////
+
+    void clear() noexcept {
+        for (size_type i = 0; i < m_size; ++i) {
+            delete m_data[i];
+            freeSlot(m_dense_slot[i]);
+        }
+        m_dense_slot.clear();
+        m_size = 0;
+    }
+
+    SlotHandle insert(std::unique_ptr<T> t) {
+        assert(t);
+        auto const handle = insertImpl(t.get());
+        t.release();
+        return handle;
+    }
+
+    template<detail::DerivedOrEqualTo<T> U>
+    SlotHandle insert(U &&t) {
+        using Ctor = std::remove_cvref_t<U>;
+        return insert(std::unique_ptr<T>(new Ctor(std::forward<U>(t))));
+    }
+
+    /// Construct new item in-place
+    template<detail::DerivedOrEqualTo<T> U = T, typename... Args>
+    SlotHandle emplace(Args &&...args) {
+        using Ctor = std::remove_cvref_t<U>;
+        return insert(std::unique_ptr<T>(new Ctor(std::forward<Args>(args)...)));
+    }
+
+    /// Erase the element referred to by `handle`. Returns false if it was already erased.
+    bool erase(SlotHandle handle) {
+        if (!contains(handle)) return false;
+        erase(const_iterator(m_data + m_slots[handle.index].index));
+        return true;
+    }
+
+    /** Erase the element at `pos` by moving the last element into its place.
+     *
+     * Returns an iterator to the element which took its place (or `end()`).
+     */
+    iterator erase(const_iterator pos) {
+        auto const idx = size_type(detail::distance(const_iterator(m_data), pos));
+        assert(idx < m_size);
+        delete unlink(idx);
+        return m_data + idx;
+    }
+
+    /// Remove the element referred to by `handle` and return it, or `nullptr` if it was erased
+    std::unique_ptr<T> release(SlotHandle handle) {
+        if (!contains(handle)) return nullptr;
+        return std::unique_ptr<T>(unlink(m_slots[handle.index].index));
+    }
+
+    void swap(PtrSlotMap &other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_cap, other.m_cap);
+        m_dense_slot.swap(other.m_dense_slot);
+        m_slots.swap(other.m_slots);
+        std::swap(m_free, other.m_free);
+    }
+
+private:
+    SlotHandle insertImpl(T *ptr) {
+        ensureExtraCapacity(1);
+        m_dense_slot.reserve(m_cap);
+        if (m_free == SlotHandle::invalid) {
+            assert(m_slots.size() < SlotHandle::invalid);
+            m_slots.push_back({SlotHandle::invalid, 0});
+            m_free = std::uint32_t(m_slots.size() - 1);
+        }
+        // Nothing below throws
+        auto const slot = m_free;
+        m_free = m_slots[slot].index;
+        m_slots[slot].index = std::uint32_t(m_size);
+        m_dense_slot.push_back(slot);
+        m_data[m_size++] = ptr;
+        return {slot, m_slots[slot].generation};
+    }
+
+    /// Remove the element at dense index `idx`, returning it
+    T *unlink(size_type idx) noexcept {
+        auto *ptr = m_data[idx];
+        freeSlot(m_dense_slot[idx]);
+        auto const last = --m_size;
+        if (idx != last) {
+            m_data[idx] = m_data[last];
+            m_dense_slot[idx] = m_dense_slot[last];
+            m_slots[m_dense_slot[idx]].index = std::uint32_t(idx);
+        }
+        m_dense_slot.pop_back();
+        return ptr;
+    }
+
+    void freeSlot(std::uint32_t slot) noexcept {
+        ++m_slots[slot].generation;
+        m_slots[slot].index = m_free;
+        m_free = slot;
+    }
+
+    void changeCapacity(size_type to) {
+        if (to == m_cap) return;
+        auto *tmp = new T *[to];
+        assert(to >= m_size);
+        if (m_size) std::memcpy(tmp, m_data, sizeof(T *) * m_size);
+        std::swap(m_data, tmp);
+        delete[] tmp;
+        m_cap = to;
+    }
+
+    void ensureExtraCapacity(size_type elems) {
+        if (m_size + elems <= m_cap) return;
+        changeCapacity(GeometricGrowth<>::grow(m_cap, m_size + elems));
+    }
+};
+
+template<typename T>
+struct IsComparableContainerBase<PtrSlotMap<T>, PtrVecView<T>> : std::true_type { };
+
+template<typename T>
+struct IsComparableContainerBase<PtrVecView<T>, PtrSlotMap<T>> : std::true_type { };
+
+/// This overload is called in ADL use of swap
+template<typename T>
+void swap(ut::PtrSlotMap<T> &a, ut::PtrSlotMap<T> &b) {
+    a.swap(b);
+}
+
+}  // namespace ut
+
+namespace std {
+/// This overload is called when swap is invoked as `std::swap`
+template<typename T>
+void swap(ut::PtrSlotMap<T> &a, ut::PtrSlotMap<T> &b) {
+    a.swap(b);
+}
+}
+
+#endif  // PTRSLOTMAP_HPP
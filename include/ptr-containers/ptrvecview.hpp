@@ -56,6 +56,15 @@ template<typename T>
 void swap(ut::PtrVecView<T> &a, ut::PtrVecView<T> &b) {
     a.swap(b);
 }
+
+/// Hashes the elements, not the pointers. Equal to the hash of an equal `ut::OwnPtrVec`.
+template<typename T>
+requires ut::detail::Hashable<T>
+struct hash<ut::PtrVecView<T>> {
+    std::size_t operator()(ut::PtrVecView<T> const &v) const {
+        return ut::detail::hashElements(v.data(), v.size());
+    }
+};
 }
 
 #endif  // PTRVECVIEW_HPP
@@ -0,0 +1,234 @@
+#ifndef RECLAIMER_HPP
+#define RECLAIMER_HPP
+
+#include "object_ops.hpp"
+#include "ownptrvec.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ut {
+
+/** Destroys objects handed to it later, on a background thread or when
+ *  `drain` is called.
+ *
+ * Used through `DeferredAllocator` (see `DeferredPtrVec`), so that erasing
+ * from or destroying a vector on a latency-critical thread only unlinks the
+ * pointers, while the destructors and the frees run elsewhere.
+ *
+ * The reclaimer has to outlive every allocator referring to it. Anything
+ * still pending when it is destroyed is reclaimed by its destructor.
+ */
+class Reclaimer {
+public:
+    using ReclaimFn = void (*)(void *) noexcept;
+
+    enum class Mode {
+        /// Reclaim on a thread owned by the reclaimer
+        background,
+        /// Only reclaim when `drain` is called (e.g. by the owning thread when idle)
+        manual,
+    };
+
+private:
+    struct Retired {
+        void *ptr;
+        ReclaimFn reclaim;
+    };
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::vector<Retired> m_pending;
+    bool m_busy = false;
+    bool m_stop = false;
+    std::thread m_thread;
+
+public:
+    explicit Reclaimer(Mode mode = Mode::background) {
+        if (mode == Mode::background) m_thread = std::thread([this] { run(); });
+    }
+
+    Reclaimer(Reclaimer const &) = delete;
+    Reclaimer &operator=(Reclaimer const &) = delete;
+
+    ~Reclaimer() {
+        if (m_thread.joinable()) {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_one();
+            m_thread.join();
+        }
+        drain();
+    }
+
+    /** Queue `reclaim(ptrs[i])` for each of the `n` pointers.
+     *
+     * If the queue cannot grow, the objects are reclaimed immediately instead.
+     */
+    template<typename P>
+    void retire(P *const *ptrs, std::size_t n, ReclaimFn reclaim) noexcept {
+        if (n == 0) return;
+        bool queued = true;
+        {
+            std::lock_guard lock(m_mutex);
+            try {
+                if (m_pending.capacity() - m_pending.size() < n)
+                    m_pending.reserve(std::max(m_pending.size() + n, 2 * m_pending.capacity()));
+            } catch (...) {
+                queued = false;
+            }
+            if (queued)
+                for (std::size_t i = 0; i < n; ++i)
+                    m_pending.push_back({toVoid(ptrs[i]), reclaim});
+        }
+        if (queued)
+            m_wake.notify_one();
+        else
+            for (std::size_t i = 0; i < n; ++i)
+                reclaim(toVoid(ptrs[i]));
+    }
+
+    /** Reclaim everything retired so far on the calling thread, including
+     *  objects retired while doing so, and wait for the background thread to
+     *  finish its current batch.
+     */
+    void drain() noexcept {
+        std::vector<Retired> batch;
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            if (!m_pending.empty()) {
+                batch.swap(m_pending);
+                lock.unlock();
+                reclaimAll(batch);
+                lock.lock();
+            } else if (m_busy)
+                m_idle.wait(lock);
+            else
+                return;
+        }
+    }
+
+    /// Number of objects waiting to be reclaimed (excluding the batch in progress)
+    std::size_t pending() const {
+        std::lock_guard lock(m_mutex);
+        return m_pending.size();
+    }
+
+private:
+    void run() noexcept {
+        std::vector<Retired> batch;
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_wake.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+            if (m_pending.empty()) return;
+            batch.swap(m_pending);
+            m_busy = true;
+            lock.unlock();
+            reclaimAll(batch);
+            lock.lock();
+            m_busy = false;
+            m_idle.notify_all();
+        }
+    }
+
+    static void reclaimAll(std::vector<Retired> &batch) noexcept {
+        for (auto const &r : batch)
+            r.reclaim(r.ptr);
+        batch.clear();
+    }
+
+    template<typename P>
+    static void *toVoid(P *ptr) {
+        return const_cast<void *>(static_cast<void const *>(ptr));
+    }
+};
+
+/** An allocator which allocates through `Inner`, but passes the elements an
+ *  `OwnPtrVec` erases to a `Reclaimer` instead of destroying them
+ *  immediately (see `DeferredPtrVec`).
+ *
+ * The reclaimer destroys and frees the objects on another thread, so `Inner`
+ * has to be stateless and thread safe (such as `std::allocator` or
+ * `MallocAllocator`), and the destructors of `T` must not rely on running on
+ * the thread which erased the element.
+ */
+template<typename T, typename Inner = std::allocator<T>>
+requires std::allocator_traits<Inner>::is_always_equal::value && std::default_initializable<Inner>
+class DeferredAllocator {
+    template<typename U, typename I>
+    requires std::allocator_traits<I>::is_always_equal::value && std::default_initializable<I>
+    friend class DeferredAllocator;
+
+    Reclaimer *m_reclaimer;
+
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template<typename U>
+    struct rebind {
+        using other = DeferredAllocator<U, typename std::allocator_traits<Inner>::template rebind_alloc<U>>;
+    };
+
+    explicit DeferredAllocator(Reclaimer &reclaimer)
+            : m_reclaimer(&reclaimer) { }
+
+    template<typename U, typename I>
+    DeferredAllocator(DeferredAllocator<U, I> const &other)
+            : m_reclaimer(other.m_reclaimer) { }
+
+    [[nodiscard]]
+    T *allocate(std::size_t n) {
+        Inner inner;
+        return std::allocator_traits<Inner>::allocate(inner, n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        Inner inner;
+        std::allocator_traits<Inner>::deallocate(inner, ptr, n);
+    }
+
+    /// Hand the `n` elements at `ptrs` (allocated by `OwnPtrVec`) to the reclaimer
+    void defer(T *const *ptrs, std::size_t n) noexcept {
+        m_reclaimer->retire(ptrs, n, &reclaim);
+    }
+
+    Reclaimer &reclaimer() const {
+        return *m_reclaimer;
+    }
+
+    template<typename U, typename I>
+    bool operator==(DeferredAllocator<U, I> const &) const {
+        return true;
+    }
+
+private:
+    static void reclaim(void *ptr) noexcept {
+        void *obj = detail::mostDerived(static_cast<T *>(ptr));
+        detail::elementHeader(obj)->ops->destroy(obj);
+        Inner inner;
+        detail::deallocateElement(inner, obj);
+    }
+};
+
+/** An `OwnPtrVec<T>` whose `erase`, `pop_back`, `clear` and destructor hand
+ *  the elements to a `Reclaimer` rather than destroying them.
+ *
+ * Construct with `auto v = DeferredPtrVec<T>(DeferredAllocator<T>(reclaimer));`.
+ */
+template<typename T>
+using DeferredPtrVec = OwnPtrVec<T, DeferredAllocator<T>>;
+
+}  // namespace ut
+
+#endif  // RECLAIMER_HPP
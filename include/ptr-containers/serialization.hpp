@@ -0,0 +1,254 @@
+#ifndef SERIALIZATION_HPP
+#define SERIALIZATION_HPP
+
+#include "ownptrvec.hpp"
+#include "template_helpers.hpp"
+#include "valueptr.hpp"
+
+#ifndef assert
+#    include <cassert>
+#endif
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace ut {
+
+/// Thrown when a stream cannot be read (or written) as the expected data
+class SerializationError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/** Writes values in their native (binary) representation to a `std::ostream`.
+ *
+ * The format is not portable between platforms with different endianness or
+ * type sizes.
+ */
+class BinaryWriter {
+    std::ostream &m_out;
+
+public:
+    explicit BinaryWriter(std::ostream &out)
+            : m_out(out) { }
+
+    void write_bytes(void const *data, std::size_t bytes) {
+        if (!m_out.write(static_cast<char const *>(data), std::streamsize(bytes)))
+            throw SerializationError("failed to write to stream");
+    }
+
+    template<typename V>
+    requires std::is_trivially_copyable_v<V>
+    void write(V const &value) {
+        write_bytes(std::addressof(value), sizeof(V));
+    }
+};
+
+/// Reads values written by a `BinaryWriter` from a `std::istream`
+class BinaryReader {
+    std::istream &m_in;
+
+public:
+    explicit BinaryReader(std::istream &in)
+            : m_in(in) { }
+
+    void read_bytes(void *data, std::size_t bytes) {
+        if (!m_in.read(static_cast<char *>(data), std::streamsize(bytes)))
+            throw SerializationError("unexpected end of stream");
+    }
+
+    template<typename V>
+    requires std::is_trivially_copyable_v<V> && std::default_initializable<V>
+    V read() {
+        V value;
+        read_bytes(std::addressof(value), sizeof(V));
+        return value;
+    }
+};
+
+/** How objects of type `D` are saved and loaded by a `TypeRegistry`.
+ *
+ * Specialise it with `static void save(BinaryWriter &, D const &)` and
+ * `static D load(BinaryReader &)`. By default types with a
+ * `void save(BinaryWriter &) const` member and a constructor taking a
+ * `BinaryReader &` use those, and trivially copyable types are copied
+ * byte by byte.
+ */
+template<typename D>
+struct Serializer {
+    static void save(BinaryWriter &out, D const &obj) {
+        if constexpr (requires { obj.save(out); })
+            obj.save(out);
+        else {
+            static_assert(std::is_trivially_copyable_v<D>, "specialise ut::Serializer for this type");
+            out.write(obj);
+        }
+    }
+
+    static D load(BinaryReader &in) {
+        if constexpr (std::is_constructible_v<D, BinaryReader &>)
+            return D(in);
+        else {
+            static_assert(std::is_trivially_copyable_v<D>, "specialise ut::Serializer for this type");
+            return in.read<D>();
+        }
+    }
+};
+
+/** Saves and loads `OwnPtrVec<Base>`s and `ValuePtr<Base>`s whose elements
+ *  are of any of the dynamic types `Ds` (which may include `Base` itself).
+ *
+ * Each element is stored as the index of its dynamic type in `Ds`, followed by
+ * the data written by `Serializer<D>`. The type ids of a vector are stored
+ * ahead of the elements, so loading an `ArenaPtrVec` can reserve one block
+ * for all of them. New types have to be added at the end of `Ds` to keep
+ * previously saved data readable.
+ *
+ * Saving an object of a type not in `Ds` throws a `SerializationError`, as
+ * does loading a malformed stream.
+ */
+template<typename Base, detail::DerivedOrEqualTo<Base>... Ds>
+class TypeRegistry {
+    static_assert(sizeof...(Ds) > 0 && sizeof...(Ds) < 0xffff);
+
+public:
+    using type_id = std::uint16_t;
+
+    /// Id stored for an empty `ValuePtr`
+    static constexpr type_id null_id = 0xffff;
+
+private:
+    static constexpr std::uint32_t vector_magic = 0x55545056;  // "UTPV"
+
+    using Types = std::tuple<Ds...>;
+
+    template<type_id Id>
+    using TypeAt = std::tuple_element_t<Id, Types>;
+
+    static inline std::array<std::type_info const *, sizeof...(Ds)> const type_infos = {&typeid(Ds)...};
+
+public:
+    /// Id of the dynamic type of `obj`
+    static type_id id_of(Base const &obj) {
+        auto const &type = typeid(obj);
+        for (type_id id = 0; id < type_infos.size(); ++id)
+            if (*type_infos[id] == type) return id;
+        throw SerializationError(std::string("type not registered: ") + type.name());
+    }
+
+    template<typename Alloc, typename Growth, typename Buffer>
+    static void save(BinaryWriter &out, OwnPtrVec<Base, Alloc, Growth, Buffer> const &vec) {
+        std::vector<type_id> ids;
+        ids.reserve(vec.size());
+        for (auto const *obj : vec)
+            ids.push_back(id_of(*obj));
+
+        out.write(vector_magic);
+        out.write(std::uint64_t(vec.size()));
+        if (!ids.empty()) out.write_bytes(ids.data(), sizeof(type_id) * ids.size());
+        for (std::size_t i = 0; i < vec.size(); ++i)
+            saveAs(ids[i], out, *vec[i]);
+    }
+
+    template<std::size_t InlineSize, bool CacheHash>
+    static void save(BinaryWriter &out, ValuePtr<Base, InlineSize, CacheHash> const &value) {
+        if (!value.get()) {
+            out.write(null_id);
+            return;
+        }
+        auto const id = id_of(*value);
+        out.write(id);
+        saveAs(id, out, *value);
+    }
+
+    /** Load a vector saved by `save`.
+     *
+     * With a region allocator (`ArenaPtrVec`), the memory of all elements is
+     * reserved at once so they end up contiguous, in index order.
+     */
+    template<typename Vec = OwnPtrVec<Base>>
+    static Vec load_vector(BinaryReader &in) {
+        if (in.read<std::uint32_t>() != vector_magic) throw SerializationError("not a saved vector");
+        auto const size = in.read<std::uint64_t>();
+
+        std::vector<type_id> ids;
+        ids.reserve(std::size_t(std::min<std::uint64_t>(size, 1 << 20)));
+        std::size_t bytes = 0;
+        for (std::uint64_t i = 0; i < size; ++i) {
+            auto const id = in.read<type_id>();
+            if (id >= sizeof...(Ds)) throw SerializationError("unknown type id");
+            ids.push_back(id);
+            bytes += blockBytes(id);
+        }
+
+        Vec vec;
+        vec.reserve(ids.size());
+        if constexpr (requires { vec.get_allocator().arena().reserve(bytes); })
+            vec.get_allocator().arena().reserve(bytes);
+        for (auto const id : ids)
+            loadInto(id, in, vec);
+        return vec;
+    }
+
+    template<typename VP = ValuePtr<Base>>
+    static VP load_value(BinaryReader &in) {
+        VP value(std::unique_ptr<Base> {});
+        auto const id = in.read<type_id>();
+        if (id == null_id) return value;
+        if (id >= sizeof...(Ds)) throw SerializationError("unknown type id");
+        loadInto(id, in, value);
+        return value;
+    }
+
+private:
+    template<type_id Id = 0>
+    static void saveAs(type_id id, BinaryWriter &out, Base const &obj) {
+        if constexpr (Id < sizeof...(Ds)) {
+            using D = TypeAt<Id>;
+            if (id == Id)
+                Serializer<D>::save(out, static_cast<D const &>(obj));
+            else
+                saveAs<Id + 1>(id, out, obj);
+        }
+    }
+
+    /// Bytes an element of type `id` takes up in a region, including padding
+    template<type_id Id = 0>
+    static std::size_t blockBytes(type_id id) {
+        if constexpr (Id < sizeof...(Ds)) {
+            if (id != Id) return blockBytes<Id + 1>(id);
+            auto const &ops = detail::objectOps<TypeAt<Id>>;
+            return detail::elementBlockSize(ops) + detail::elementBlockAlign(ops.align) - 1;
+        } else
+            return 0;
+    }
+
+    /// Load an object of type `id` and append it to the vector, or assign it to the `ValuePtr`, `target`
+    template<type_id Id = 0, typename Target>
+    static void loadInto(type_id id, BinaryReader &in, Target &target) {
+        if constexpr (Id < sizeof...(Ds)) {
+            using D = TypeAt<Id>;
+            if (id != Id) return loadInto<Id + 1>(id, in, target);
+            if constexpr (requires { target.push_back(std::declval<D>()); })
+                target.push_back(Serializer<D>::load(in));
+            else
+                target = Serializer<D>::load(in);
+        }
+    }
+};
+
+}  // namespace ut
+
+#endif  // SERIALIZATION_HPP
@@ -1,6 +1,8 @@
 #ifndef CONCEPTS_HPP
 #define CONCEPTS_HPP
 #include <concepts>
+#include <cstddef>
+#include <functional>
 #include <memory>
 
 namespace ut::detail {
@@ -45,6 +47,9 @@ concept NotUniquePtr = !IsUniquePtrV<T>;
 template<typename T>
 concept Pointer = std::is_pointer_v<T>;
 
+/// Stand-in for a member which only exists in some instantiations (use with `[[no_unique_address]]`)
+struct Empty { };
+
 [[nodiscard]]
 static constexpr auto distance(auto a, auto b) {
     return std::distance(AddTransitiveConstT<decltype(a)>(a), AddTransitiveConstT<decltype(b)>(b));
@@ -194,6 +199,13 @@ concept HasCall = requires(T t) {
     t(std::declval<Args>()...);
 };
 
+
+/// Whether `std::hash` is enabled for `T`
+template<typename T>
+concept Hashable = requires(T const &t) {
+    { std::hash<std::remove_cv_t<T>>()(t) } -> std::convertible_to<std::size_t>;
+};
+
 #undef UT_REQUIRE_UNARY
 #undef UT_REQUIRE_BINARY
 
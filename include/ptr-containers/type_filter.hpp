@@ -0,0 +1,187 @@
+#ifndef TYPE_FILTER_HPP
+#define TYPE_FILTER_HPP
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+namespace ut {
+
+namespace detail {
+    /// Shared, so views stay safe to iterate after the cache drops them
+    using TypeIndices = std::shared_ptr<std::vector<std::size_t> const>;
+
+    /// Indices of the elements of a container which are of each (requested) type, see `OwnPtrVec::view_of`
+    class TypeFilterCache {
+        struct Entry {
+            std::type_index type;
+            TypeIndices indices;
+        };
+
+        std::vector<Entry> m_entries;
+
+    public:
+        /// The cached indices for `type`, or `nullptr`
+        TypeIndices find(std::type_index type) const {
+            for (auto const &entry : m_entries)
+                if (entry.type == type) return entry.indices;
+            return nullptr;
+        }
+
+        /// The cached indices for `type`, calling `build()` to compute them if missing
+        template<typename Build>
+        TypeIndices indices(std::type_index type, Build &&build) {
+            if (auto found = find(type)) return found;
+            return m_entries.emplace_back(Entry {type, build()}).indices;
+        }
+    };
+}  // namespace detail
+
+/** A range over the elements of a container of pointers to `Base` which are
+ *  `Derived` objects, yielding `Derived *` (see `OwnPtrVec::view_of`).
+ *
+ * The matching indices are computed (with `dynamic_cast`) when the view is
+ * first requested, so iterating does not touch the other elements. The view
+ * is invalidated by any modification of the container.
+ */
+template<typename Base, typename Derived>
+class TypeFilteredView {
+    Base *const *m_data = nullptr;
+    std::size_t const *m_indices = nullptr;
+    std::size_t m_size = 0;
+    detail::TypeIndices m_owner;
+
+    static Derived *cast(Base *ptr) {
+        if constexpr (requires { static_cast<Derived *>(ptr); })
+            return static_cast<Derived *>(ptr);
+        else
+            return dynamic_cast<Derived *>(ptr);
+    }
+
+public:
+    class iterator {
+        Base *const *m_data = nullptr;
+        std::size_t const *m_idx = nullptr;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Derived *;
+        using difference_type = std::ptrdiff_t;
+        using reference = Derived *;
+        using pointer = void;
+
+        iterator() = default;
+
+        iterator(Base *const *data, std::size_t const *idx)
+                : m_data(data)
+                , m_idx(idx) { }
+
+        reference operator*() const {
+            return cast(m_data[*m_idx]);
+        }
+
+        reference operator[](difference_type n) const {
+            return cast(m_data[m_idx[n]]);
+        }
+
+        iterator &operator++() {
+            ++m_idx;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto tmp = *this;
+            ++m_idx;
+            return tmp;
+        }
+
+        iterator &operator--() {
+            --m_idx;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            auto tmp = *this;
+            --m_idx;
+            return tmp;
+        }
+
+        iterator &operator+=(difference_type n) {
+            m_idx += n;
+            return *this;
+        }
+
+        iterator &operator-=(difference_type n) {
+            m_idx -= n;
+            return *this;
+        }
+
+        friend iterator operator+(iterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend iterator operator+(difference_type n, iterator it) {
+            return it += n;
+        }
+
+        friend iterator operator-(iterator it, difference_type n) {
+            return it -= n;
+        }
+
+        friend difference_type operator-(iterator const &a, iterator const &b) {
+            return a.m_idx - b.m_idx;
+        }
+
+        friend bool operator==(iterator const &a, iterator const &b) {
+            return a.m_idx == b.m_idx;
+        }
+
+        friend std::strong_ordering operator<=>(iterator const &a, iterator const &b) {
+            return std::compare_three_way()(a.m_idx, b.m_idx);
+        }
+    };
+
+    using const_iterator = iterator;
+
+    TypeFilteredView() = default;
+
+    TypeFilteredView(Base *const *data, detail::TypeIndices indices)
+            : m_data(data)
+            , m_indices(indices->data())
+            , m_size(indices->size())
+            , m_owner(std::move(indices)) { }
+
+    iterator begin() const {
+        return iterator(m_data, m_indices);
+    }
+
+    iterator end() const {
+        return iterator(m_data, m_indices + m_size);
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    Derived *operator[](std::size_t i) const {
+        return cast(m_data[m_indices[i]]);
+    }
+
+    /// Index of the `i`th matching element in the container
+    std::size_t index(std::size_t i) const {
+        return m_indices[i];
+    }
+};
+
+}  // namespace ut
+
+#endif  // TYPE_FILTER_HPP
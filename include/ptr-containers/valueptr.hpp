@@ -1,79 +1,151 @@
 #ifndef VALUEPTR_HPP
 #define VALUEPTR_HPP
+#include "object_ops.hpp"
 #include "template_helpers.hpp"
 
+#ifndef assert
+#    include <cassert>
+#endif
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
 #include <utility>
 
 namespace ut {
 
-template<typename T>
+namespace detail {
+    template<std::size_t Size>
+    struct alignas(std::max_align_t) InlineBuffer {
+        std::byte data[Size];
+    };
+
+    /// The hash of a `ValuePtr`'s object, once computed
+    struct HashCache {
+        std::atomic<std::size_t> value = 0;
+        std::atomic<bool> valid = false;
+
+        void invalidate() noexcept {
+            valid.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    /// Stands in for the recorded `ObjectOps` of a `ValuePtr` without inline storage
+    struct NoObjectOps { };
+
+    /// Stands in for the `HashCache`; distinct from `Empty` so the two can share an address
+    struct NoHashCache { };
+}
+
+/** A pointer to `T` (or a type derived from it) with value semantics.
+ *
+ * If `InlineSize` is not 0, objects which fit into `InlineSize` bytes (and
+ * whose alignment is at most that of `std::max_align_t` and which can be moved
+ * without throwing) are stored inside the `ValuePtr` instead of being
+ * allocated on the heap. Larger objects are still heap allocated.
+ *
+ * Copies are made with the dynamic type of the object. Without inline
+ * storage the `ValuePtr` is a single pointer, and the operations of a
+ * polymorphic object's dynamic type are looked up by its `typeid` (every type
+ * a `ValuePtr` constructs is registered for this). An object adopted from a
+ * `std::unique_ptr` whose dynamic type was never registered (see
+ * `register_dynamic_type`) is copied as the static type, or if that is
+ * abstract (or not copyable), copying throws `UnknownDynamicTypeError`.
+ * Copying an object whose dynamic type is not copy constructible throws
+ * `NonCopyableDynamicTypeError`.
+ *
+ * If `CacheHash` is true, `hash()` stores the object's hash after computing it
+ * and reuses it until the object is next accessed through a non-const
+ * `get()`, `operator->`, `operator*` or `operator()`, or replaced. Use the
+ * const accessors to keep the cached hash.
+ */
+template<typename T, std::size_t InlineSize = 0, bool CacheHash = false>
 class ValuePtr {
-    template<typename U>
+    template<typename U, std::size_t, bool>
     friend class ValuePtr;
 
 private:
+    static constexpr std::size_t inline_align = alignof(std::max_align_t);
+
+    template<typename U>
+    static constexpr bool fits_inline =
+        sizeof(U) <= InlineSize && alignof(U) <= inline_align && std::is_nothrow_move_constructible_v<U>;
+
     T *m_obj = nullptr;
+    /// Operations on the dynamic type of an object which may be inline, `nullptr` if not known (see `ops`)
+    [[no_unique_address]] std::conditional_t<(InlineSize > 0), detail::ObjectOps const *, detail::NoObjectOps> m_ops {};
+    [[no_unique_address]] std::conditional_t<(InlineSize > 0), detail::InlineBuffer<InlineSize>, detail::Empty> m_buf;
+    [[no_unique_address]] mutable std::conditional_t<CacheHash, detail::HashCache, detail::NoHashCache> m_hash;
 
 public:  ////////// constructors //////////
-    ValuePtr()
-            : m_obj(new T {}) { }
+    ValuePtr() {
+        construct<T>();
+    }
 
     template<detail::DerivedOrEqualTo<T> U>
     ValuePtr(U &&obj) {
-        m_obj = new std::remove_cvref_t<U>(std::forward<U>(obj));
+        construct<std::remove_cvref_t<U>>(std::forward<U>(obj));
     }
 
     template<detail::DerivedOrEqualTo<T> U>
     explicit ValuePtr(std::unique_ptr<U> obj) {
+        auto const *ops = knownOps(obj.get());
+        if (ops) detail::registerObjectOps<U>();
+        setOps(ops);
         m_obj = obj.release();
     }
 
     ValuePtr(ValuePtr const &other) {
-        m_obj = new T(*other.m_obj);
+        copyFrom(other);
     }
 
-    template<detail::DerivedOrEqualTo<T> U>
-    ValuePtr(ValuePtr<U> const &other) {
-        m_obj = new std::remove_cvref_t<U>(*other.m_obj);
+    template<detail::DerivedOrEqualTo<T> U, std::size_t OtherSize, bool OtherCache>
+    ValuePtr(ValuePtr<U, OtherSize, OtherCache> const &other) {
+        copyFrom(other);
     }
 
     ValuePtr &operator=(ValuePtr const &other) {
-        delete m_obj;
-        m_obj = new T(*other.m_obj);
+        if (this == &other) return *this;
+        reset();
+        copyFrom(other);
         return *this;
     }
 
-    template<detail::DerivedOrEqualTo<T> U>
-    ValuePtr &operator=(ValuePtr<U> const &other) {
-        delete m_obj;
-        m_obj = new std::remove_cvref_t<U>(*other.m_obj);
+    template<detail::DerivedOrEqualTo<T> U, std::size_t OtherSize, bool OtherCache>
+    ValuePtr &operator=(ValuePtr<U, OtherSize, OtherCache> const &other) {
+        if (static_cast<void const *>(this) == static_cast<void const *>(&other)) return *this;
+        reset();
+        copyFrom(other);
         return *this;
     }
 
     template<detail::DerivedOrEqualTo<T> U>
     ValuePtr &operator=(U &&other) {
-        delete m_obj;
-        m_obj = new std::remove_cvref_t<U>(std::forward<U>(other));
+        // `other` may be the object owned by this, so construct the new one first
+        ValuePtr tmp(std::forward<U>(other));
+        reset();
+        moveFrom(std::move(tmp));
         return *this;
     }
 
-    template<detail::DerivedOrEqualTo<T> U>
-    ValuePtr(ValuePtr<U> &&other) {
-        *this = std::move(other);
+    template<detail::DerivedOrEqualTo<T> U, std::size_t OtherSize, bool OtherCache>
+    ValuePtr(ValuePtr<U, OtherSize, OtherCache> &&other) {
+        moveFrom(std::move(other));
     }
 
-    template<detail::DerivedOrEqualTo<T> U>
-    ValuePtr &operator=(ValuePtr<U> &&other) {
-        delete m_obj;
-        m_obj = other.m_obj;
-        other.m_obj = nullptr;
+    template<detail::DerivedOrEqualTo<T> U, std::size_t OtherSize, bool OtherCache>
+    ValuePtr &operator=(ValuePtr<U, OtherSize, OtherCache> &&other) {
+        if (static_cast<void const *>(this) == static_cast<void const *>(&other)) return *this;
+        reset();
+        moveFrom(std::move(other));
         return *this;
     }
 
     ~ValuePtr() {
-        delete m_obj;
-        m_obj = nullptr;
+        reset();
     }
 
 public:  ////////// functions //////////
@@ -81,12 +153,14 @@ public:  ////////// functions //////////
     /** Get the underlying pointer.
      *
      * ValuePtr still owns the memeory - pointer will become invalid when this
-     * object goes out of scope.
+     * object goes out of scope (or is moved from, if the object is stored
+     * inline).
      *
      * \note This API should rarely be used. To obtain a reference to the
      *       contained object use `operator*`
      */
     T *get() {
+        invalidateHash();
         return m_obj;
     }
 
@@ -95,19 +169,188 @@ public:  ////////// functions //////////
     }
 
     /** Get ownership of the underlying pointer
+     *
+     * NOTE: An object stored inline is moved to the heap first.
      */
     std::unique_ptr<T> release() {
-        auto *tmp = m_obj;
-        m_obj = nullptr;
-        return std::unique_ptr<T> {tmp};
+        if (!is_inline()) {
+            setOps(nullptr);
+            return std::unique_ptr<T> {std::exchange(m_obj, nullptr)};
+        }
+        assert(ops()->move_new);
+        T *obj = detail::rebase(m_obj, buffer(), ops()->move_new(buffer()));
+        reset();
+        return std::unique_ptr<T> {obj};
     }
 
     void swap(ValuePtr &other) {
-        std::swap(m_obj, other.m_obj);
+        invalidateHash();
+        other.invalidateHash();
+        if (!is_inline() && !other.is_inline()) {
+            std::swap(m_obj, other.m_obj);
+            std::swap(m_ops, other.m_ops);
+            return;
+        }
+        ValuePtr tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    /// Whether the object is stored inside the `ValuePtr` (rather than on the heap)
+    bool is_inline() const {
+        if constexpr (InlineSize > 0) {
+            auto const *obj = reinterpret_cast<std::byte const *>(m_obj);
+            return std::less_equal<>()(m_buf.data, obj) && std::less<>()(obj, m_buf.data + InlineSize);
+        } else
+            return false;
+    }
+
+    /** Hash of the object (not the pointer), with `std::hash<T>`.
+     *
+     * To hash polymorphic objects by their dynamic type, specialise
+     * `std::hash<T>` to call a virtual function.
+     */
+    std::size_t hash() const requires detail::Hashable<T> {
+        if (!m_obj) return 0;
+        if constexpr (CacheHash) {
+            if (m_hash.valid.load(std::memory_order_acquire)) return m_hash.value.load(std::memory_order_relaxed);
+            auto const h = std::hash<std::remove_cv_t<T>>()(*m_obj);
+            m_hash.value.store(h, std::memory_order_relaxed);
+            m_hash.valid.store(true, std::memory_order_release);
+            return h;
+        } else
+            return std::hash<std::remove_cv_t<T>>()(*m_obj);
+    }
+
+private:
+    void invalidateHash() noexcept {
+        if constexpr (CacheHash) m_hash.invalidate();
+    }
+
+    /// Operations on the dynamic type of the object, `nullptr` if there is none or it is not known
+    detail::ObjectOps const *ops() const {
+        if constexpr (InlineSize > 0)
+            if (m_ops || !m_obj) return m_ops;
+        return m_obj ? detail::dynamicObjectOps(*m_obj) : nullptr;
+    }
+
+    void setOps([[maybe_unused]] detail::ObjectOps const *ops) noexcept {
+        if constexpr (InlineSize > 0) m_ops = ops;
+    }
+
+    /// Take over the cached hash of `other`, which holds an equal object
+    template<typename U, std::size_t OtherSize, bool OtherCache>
+    void copyHash(ValuePtr<U, OtherSize, OtherCache> const &other) noexcept {
+        if constexpr (CacheHash && OtherCache && std::is_same_v<std::remove_cv_t<U>, std::remove_cv_t<T>>) {
+            if (other.m_hash.valid.load(std::memory_order_acquire)) {
+                m_hash.value.store(other.m_hash.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                m_hash.valid.store(true, std::memory_order_release);
+            }
+        }
+    }
+
+    void *buffer() {
+        if constexpr (InlineSize > 0)
+            return m_buf.data;
+        else
+            return nullptr;
+    }
+
+    void const *buffer() const {
+        if constexpr (InlineSize > 0)
+            return m_buf.data;
+        else
+            return nullptr;
+    }
+
+    /// Whether an object with these `ops` can be stored in this buffer
+    static bool fitsInline(detail::ObjectOps const &ops) {
+        return ops.size <= InlineSize && ops.align <= inline_align && ops.nothrow_move;
+    }
+
+    /// The operations of `U` if it is the dynamic type of `obj`
+    template<typename U>
+    static detail::ObjectOps const *knownOps(U const *obj) {
+        if constexpr (std::is_polymorphic_v<U>)
+            if (!obj || typeid(*obj) != typeid(U)) return nullptr;
+        return &detail::objectOps<U>;
+    }
+
+    /// Requires `m_obj` to be `nullptr`
+    template<typename U, typename... Args>
+    void construct(Args &&...args) {
+        if constexpr (fits_inline<U>) {
+            m_obj = ::new (buffer()) U(std::forward<Args>(args)...);
+            assert(detail::mostDerived(m_obj) == buffer());
+        } else {
+            U *obj = new U(std::forward<Args>(args)...);
+            m_obj = obj;
+            assert(detail::mostDerived(m_obj) == obj);
+        }
+        detail::registerObjectOps<U>();
+        setOps(&detail::objectOps<U>);
+    }
+
+    void reset() noexcept {
+        invalidateHash();
+        if (is_inline())
+            ops()->destroy(buffer());
+        else
+            delete m_obj;
+        m_obj = nullptr;
+        setOps(nullptr);
+    }
+
+    /// Requires `m_obj` to be `nullptr`
+    template<typename U, std::size_t OtherSize, bool OtherCache>
+    void copyFrom(ValuePtr<U, OtherSize, OtherCache> const &other) {
+        using Static = std::remove_cvref_t<U>;
+        if (!other.m_obj) return;
+        auto const *ops = other.ops();
+        if (!ops) {
+            if constexpr (std::is_copy_constructible_v<Static> && !std::is_abstract_v<Static>) {
+                m_obj = new Static(*other.m_obj);
+                setOps(&detail::objectOps<Static>);
+                return;
+            } else
+                throw UnknownDynamicTypeError(typeid(*other.m_obj));
+        }
+        if (!ops->copy) throw NonCopyableDynamicTypeError(typeid(*other.m_obj));
+        T const *src = other.m_obj;
+        void const *from = detail::mostDerived(src);
+        if (fitsInline(*ops)) {
+            ops->copy(from, buffer());
+            m_obj = const_cast<T *>(detail::rebase(src, from, buffer()));
+        } else
+            m_obj = const_cast<T *>(detail::rebase(src, from, ops->copy_new(from)));
+        setOps(ops);
+        copyHash(other);
+    }
+
+    /// Requires `m_obj` to be `nullptr`
+    template<typename U, std::size_t OtherSize, bool OtherCache>
+    void moveFrom(ValuePtr<U, OtherSize, OtherCache> &&other) {
+        copyHash(other);
+        if (!other.is_inline()) {
+            if constexpr (OtherSize > 0) setOps(std::exchange(other.m_ops, nullptr));
+            m_obj = std::exchange(other.m_obj, nullptr);
+            other.invalidateHash();
+            return;
+        }
+        T *src = other.m_obj;
+        auto const *ops = other.ops();
+        if (fitsInline(*ops)) {
+            ops->move(other.buffer(), buffer());
+            m_obj = detail::rebase(src, other.buffer(), buffer());
+        } else
+            m_obj = detail::rebase(src, other.buffer(), ops->move_new(other.buffer()));
+        setOps(ops);
+        other.reset();
     }
 
 public:  ////////// operators //////////
     T *operator->() {
+        invalidateHash();
         return m_obj;
     }
 
@@ -116,6 +359,7 @@ public:  ////////// operators //////////
     }
 
     T &operator*() {
+        invalidateHash();
         return *m_obj;
     }
 
@@ -135,13 +379,14 @@ public:
         return *m_obj == u;
     }
 
-    template<typename U>
-    bool operator==(ValuePtr<U> const &u) const requires(detail::HasEqual<T, U>) {
+    template<typename U, std::size_t OtherSize, bool OtherCache>
+    bool operator==(ValuePtr<U, OtherSize, OtherCache> const &u) const requires(detail::HasEqual<T, U>) {
         return *m_obj == *u.m_obj;
     }
 
     template<typename... Args>
     OpRetT<std::invoke_result_t<T, Args...>> operator()(Args &&...args) requires(detail::HasCall<T, Args...>) {
+        invalidateHash();
         return OpRetT<std::invoke_result_t<T, Args...>> {(*m_obj)(std::forward<Args>(args)...)};
     }
 
@@ -157,18 +402,27 @@ template<typename T>
 ValuePtr(T t) -> ValuePtr<T>;
 
 /// This overload is called in ADL use of swap
-template<typename T>
-void swap(ut::ValuePtr<T> &a, ut::ValuePtr<T> &b) {
+template<typename T, std::size_t InlineSize, bool CacheHash>
+void swap(ut::ValuePtr<T, InlineSize, CacheHash> &a, ut::ValuePtr<T, InlineSize, CacheHash> &b) {
     a.swap(b);
 }
 }  // namespace ut
 
 namespace std {
 /// This overload is called when swap is invoked as `std::swap`
-template<typename T>
-void swap(ut::ValuePtr<T> &a, ut::ValuePtr<T> &b) {
+template<typename T, std::size_t InlineSize, bool CacheHash>
+void swap(ut::ValuePtr<T, InlineSize, CacheHash> &a, ut::ValuePtr<T, InlineSize, CacheHash> &b) {
     a.swap(b);
 }
+
+/// Hashes the object, not the pointer
+template<typename T, std::size_t InlineSize, bool CacheHash>
+requires ut::detail::Hashable<T>
+struct hash<ut::ValuePtr<T, InlineSize, CacheHash>> {
+    std::size_t operator()(ut::ValuePtr<T, InlineSize, CacheHash> const &v) const {
+        return v.hash();
+    }
+};
 }
 
 #endif  // VALUEPTR_HPP
@@ -0,0 +1,274 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/arena.hpp>
+#include <ptr-containers/ownptrvec.hpp>
+
+using namespace ut;
+
+TEST_CASE("Arena: allocation", "[utils][Arena]") {
+    Arena arena(1024);
+    REQUIRE(arena.reserved_bytes() == 0);
+
+    SECTION("bump allocation") {
+        auto *a = static_cast<std::byte *>(arena.allocate(8, 8));
+        auto *b = static_cast<std::byte *>(arena.allocate(8, 8));
+        REQUIRE(b == a + 8);
+        REQUIRE(arena.reserved_bytes() == 1024);
+    }
+
+    SECTION("alignment") {
+        (void)arena.allocate(1, 1);
+        auto *p = arena.allocate(16, 64);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+    }
+
+    SECTION("new chunks") {
+        for (int i = 0; i < 100; ++i)
+            (void)arena.allocate(100, 8);
+        REQUIRE(arena.reserved_bytes() >= 100 * 100);
+
+        auto *big = arena.allocate(4096, 8);
+        REQUIRE(big != nullptr);
+    }
+
+    SECTION("release") {
+        (void)arena.allocate(100, 8);
+        arena.release();
+        REQUIRE(arena.reserved_bytes() == 0);
+        REQUIRE(arena.allocate(100, 8) != nullptr);
+    }
+}
+
+TEST_CASE("ArenaAllocator: sharing", "[utils][Arena]") {
+    ArenaAllocator<int> a;
+    ArenaAllocator<long> b = a;
+    ArenaAllocator<int> c;
+
+    REQUIRE(a == b);
+    REQUIRE_FALSE(a == c);
+    REQUIRE(&a.arena() == &b.arena());
+
+    ArenaAllocator<int> moved = std::move(a);
+    REQUIRE(moved == a);
+
+    REQUIRE_FALSE(b.try_release());
+    REQUIRE(c.try_release());
+}
+
+TEST_CASE("ArenaPtrVec: region release", "[utils][Arena][OwnPtrVec]") {
+    struct Point {
+        int x, y;
+    };
+
+    struct Counted {
+        int *m_dtors;
+
+        Counted(int *dtors)
+                : m_dtors(dtors) { }
+
+        ~Counted() {
+            ++*m_dtors;
+        }
+    };
+
+    SECTION("elements come from one region") {
+        ArenaPtrVec<Point> v;
+        for (int i = 0; i < 10; ++i)
+            v.push_back(Point {i, i});
+        REQUIRE(v.size() == 10);
+        REQUIRE(v[9]->x == 9);
+        REQUIRE(v.get_allocator().arena().reserved_bytes() == Arena::default_chunk_size);
+        auto *first = reinterpret_cast<std::byte *>(v[0]);
+        auto *last = reinterpret_cast<std::byte *>(v[9]);
+        REQUIRE(last > first);
+        REQUIRE(std::size_t(last - first) < 1024);
+    }
+
+    SECTION("clear frees the region if all elements are trivially destructible") {
+        ArenaPtrVec<Point> v;
+        for (int i = 0; i < 10'000; ++i)
+            v.push_back(Point {i, i});
+        auto const &arena = v.get_allocator().arena();
+        REQUIRE(arena.reserved_bytes() > 2 * Arena::default_chunk_size);
+        auto const cap = v.capacity();
+        v.clear();
+        REQUIRE(v.size() == 0);
+        REQUIRE(v.capacity() == cap);
+        // Only the (new) pointer buffer is left
+        REQUIRE(arena.reserved_bytes() <= std::max(Arena::default_chunk_size, cap * sizeof(Point *) + 128));
+        v.push_back(Point {1, 2});
+        REQUIRE(v[0]->y == 2);
+    }
+
+    SECTION("region is not freed while it is shared") {
+        ArenaPtrVec<Point> v;
+        v.push_back(Point {1, 2});
+        auto alloc = v.get_allocator();
+        v.clear();
+        REQUIRE(v.size() == 0);
+        REQUIRE(alloc.arena().reserved_bytes() > 0);
+    }
+
+    SECTION("non-trivial elements are destroyed") {
+        int dtors = 0;
+        {
+            ArenaPtrVec<Counted> v;
+            v.emplace_back(&dtors);
+            v.emplace_back(&dtors);
+            v.clear();
+            REQUIRE(dtors == 2);
+            v.emplace_back(&dtors);
+        }
+        REQUIRE(dtors == 3);
+    }
+
+    SECTION("move") {
+        ArenaPtrVec<Point> v1;
+        v1.push_back(Point {1, 2});
+        ArenaPtrVec<Point> v2 = std::move(v1);
+        REQUIRE(v2.size() == 1);
+        REQUIRE(v2[0]->x == 1);
+        v1.push_back(Point {3, 4});
+        REQUIRE(v1[0]->x == 3);
+        REQUIRE(v1.get_allocator() != v2.get_allocator());
+    }
+
+    SECTION("a moved-from vector gets its own region") {
+        ArenaPtrVec<Point> pool;
+        std::vector<std::size_t> reserved;
+        for (int round = 0; round < 5; ++round) {
+            for (int i = 0; i < 10'000; ++i)
+                pool.push_back(Point {i, i});
+            reserved.push_back(pool.get_allocator().arena().reserved_bytes());
+            if (round % 2) {
+                ArenaPtrVec<Point> batch;
+                batch.push_back(Point {0, 0});
+                batch = std::move(pool);
+                REQUIRE(batch.size() == 10'000);
+            } else {
+                ArenaPtrVec<Point> batch = std::move(pool);
+                REQUIRE(batch.size() == 10'000);
+            }
+            REQUIRE(pool.empty());
+            REQUIRE(pool.get_allocator().arena().reserved_bytes() == 0);
+        }
+        REQUIRE(std::all_of(reserved.begin(), reserved.end(), [&](std::size_t r) { return r == reserved[0]; }));
+    }
+}
+
+TEST_CASE("ArenaPtrVec: parallel clear", "[utils][Arena][OwnPtrVec]") {
+    struct Counted {
+        std::atomic<int> *dtors;
+
+        Counted(std::atomic<int> *d)
+                : dtors(d) { }
+
+        ~Counted() {
+            dtors->fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<int> dtors = 0;
+    ArenaPtrVec<Counted> v;
+    for (int i = 0; i < 20'000; ++i)
+        v.emplace_back(&dtors);
+    auto const &arena = v.get_allocator().arena();
+    REQUIRE(arena.reserved_bytes() > 2 * Arena::default_chunk_size);
+    auto const cap = v.capacity();
+
+    v.clear_parallel(4);
+    REQUIRE(v.empty());
+    REQUIRE(dtors == 20'000);
+    // Only the (new) pointer buffer is left
+    REQUIRE(arena.reserved_bytes() <= std::max(Arena::default_chunk_size, cap * sizeof(Counted *) + 128));
+
+    v.emplace_back(&dtors);
+    REQUIRE(v.size() == 1);
+}
+
+TEST_CASE("ArenaPtrVec: defragment", "[utils][Arena][OwnPtrVec]") {
+    struct Base {
+        int *m_dtors;
+        int m_value;
+
+        Base(int *dtors, int value)
+                : m_dtors(dtors)
+                , m_value(value) { }
+
+        Base(Base &&other) noexcept
+                : m_dtors(other.m_dtors)
+                , m_value(other.m_value) { }
+
+        virtual int value() const {
+            return m_value;
+        }
+
+        virtual ~Base() {
+            ++*m_dtors;
+        }
+    };
+
+    struct Derived : public Base {
+        long m_extra[8] = {};
+
+        Derived(int *dtors, int value)
+                : Base(dtors, value) {
+            m_extra[7] = value;
+        }
+
+        int value() const override {
+            return int(m_extra[7]) + 1000;
+        }
+    };
+
+    int dtors = 0;
+    {
+        ArenaPtrVec<Base> v;
+        for (int i = 0; i < 1000; ++i) {
+            if (i % 2)
+                v.emplace_back<Derived>(&dtors, i);
+            else
+                v.emplace_back(&dtors, i);
+        }
+        // Scatter the elements: erase some and insert new ones at the front
+        for (int i = 0; i < 500; ++i)
+            v.erase(v.begin() + i);
+        for (int i = 0; i < 50; ++i)
+            v.insert(v.begin(), Derived(&dtors, 2000 + i));
+        auto const live_dtors = dtors;
+
+        std::vector<int> values;
+        for (auto *e : v)
+            values.push_back(e->value());
+        auto const reserved = v.get_allocator().arena().reserved_bytes();
+
+        v.defragment();
+
+        REQUIRE(v.size() == values.size());
+        for (std::size_t i = 0; i < v.size(); ++i)
+            REQUIRE(v[i]->value() == values[i]);
+        for (std::size_t i = 1; i < v.size(); ++i) {
+            auto const a = reinterpret_cast<std::uintptr_t>(v[i - 1]);
+            auto const b = reinterpret_cast<std::uintptr_t>(v[i]);
+            REQUIRE(b > a);
+            REQUIRE(b - a <= sizeof(Derived) + 16);
+        }
+        // The old objects were destroyed, the new ones are not
+        REQUIRE(dtors == live_dtors + int(v.size()));
+        REQUIRE(v.get_allocator().arena().reserved_bytes() < reserved);
+
+        v.push_back(Base(&dtors, 1));
+        REQUIRE(v.back()->value() == 1);
+    }
+    REQUIRE(dtors > 0);
+}
@@ -0,0 +1,180 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/concatptrvecview.hpp>
+#include <ptr-containers/ownptrvec.hpp>
+
+using namespace ut;
+
+template<typename V>
+concept BeginOnRvalue = requires { std::declval<V>().begin(); };
+
+TEST_CASE("ConcatPtrVecView: constructors", "[utils][ConcatPtrVecView]") {
+    OwnPtrVec<int> a, b, c;
+    for (int i = 0; i < 3; ++i)
+        a.push_back(i);
+    for (int i = 3; i < 8; ++i)
+        c.push_back(i);
+
+    SECTION("empty") {
+        ConcatPtrVecView<int> v;
+        REQUIRE(v.empty());
+        REQUIRE(v.begin() == v.end());
+    }
+
+    SECTION("from views") {
+        ConcatPtrVecView<int> v {a.view(), b.view(), c.view()};
+        REQUIRE(v.size() == 8);
+        REQUIRE(v.segments().size() == 2);
+    }
+
+    SECTION("from a range of containers") {
+        std::vector<OwnPtrVec<int> const *> vecs {&a, &b, &c};
+        ConcatPtrVecView<int> v;
+        for (auto const *vec : vecs)
+            v.append(*vec);
+        REQUIRE(v.size() == 8);
+
+        std::vector<PtrVecView<int>> views {a.view(), b.view(), c.view()};
+        ConcatPtrVecView<int> w(views);
+        REQUIRE(w.size() == 8);
+        REQUIRE(std::equal(v.begin(), v.end(), w.begin(), w.end()));
+    }
+}
+
+TEST_CASE("ConcatPtrVecView: element access", "[utils][ConcatPtrVecView]") {
+    std::vector<OwnPtrVec<int>> vecs(4);
+    int n = 0;
+    for (std::size_t seg = 0; seg < vecs.size(); ++seg)
+        for (std::size_t i = 0; i < seg * 2; ++i)
+            vecs[seg].push_back(n++);
+
+    ConcatPtrVecView<int> v(vecs);
+    REQUIRE(v.size() == std::size_t(n));
+    REQUIRE(*v.front() == 0);
+    REQUIRE(*v.back() == n - 1);
+
+    for (int i = 0; i < n; ++i)
+        REQUIRE(*v[std::size_t(i)] == i);
+
+    SECTION("iteration") {
+        int expected = 0;
+        for (auto const *ptr : v)
+            REQUIRE(*ptr == expected++);
+        REQUIRE(expected == n);
+
+        expected = 0;
+        v.for_each([&](int const &x) { REQUIRE(x == expected++); });
+        REQUIRE(expected == n);
+    }
+
+    SECTION("random access iterator") {
+        auto it = v.begin();
+        REQUIRE(v.end() - it == n);
+        it += 5;
+        REQUIRE(**it == 5);
+        REQUIRE(*it[-3] == 2);
+        REQUIRE(**(it - 5) == 0);
+        --it;
+        REQUIRE(**it == 4);
+        REQUIRE(it < v.end());
+        REQUIRE(it + (n - 4) == v.end());
+
+        auto found = std::lower_bound(v.begin(), v.end(), 7, [](int const *p, int x) { return *p < x; });
+        REQUIRE(found - v.begin() == 7);
+    }
+}
+
+TEST_CASE("ConcatPtrVecView: iterators outlive moves", "[utils][ConcatPtrVecView]") {
+    std::vector<OwnPtrVec<int>> vecs(3);
+    for (int i = 0; i < 9; ++i)
+        vecs[std::size_t(i / 3)].push_back(i);
+
+    ConcatPtrVecView<int> v(vecs);
+    auto it = v.begin() + 2;
+    auto const end = v.end();
+    auto moved = std::move(v);
+    REQUIRE(**it == 2);
+    REQUIRE(**++it == 3);
+    it += 5;
+    REQUIRE(**it == 8);
+    REQUIRE(++it == end);
+    REQUIRE(end == moved.end());
+
+    STATIC_REQUIRE(!BeginOnRvalue<ConcatPtrVecView<int>>);
+    STATIC_REQUIRE(BeginOnRvalue<ConcatPtrVecView<int> &>);
+}
+
+TEST_CASE("ConcatPtrVecView: comparison and hashing", "[utils][ConcatPtrVecView]") {
+    OwnPtrVec<int> a, b, all;
+    for (int i = 0; i < 200; ++i) {
+        (i < 150 ? a : b).push_back(i);
+        all.push_back(i);
+    }
+
+    ConcatPtrVecView<int> v {a.view(), b.view()};
+    ConcatPtrVecView<int> split {a.view(0, 10), a.view(10, 150), b.view()};
+    REQUIRE(v == split);
+    REQUIRE(v == all);
+    REQUIRE(all == v);
+    REQUIRE(v == all.view());
+    REQUIRE(std::is_eq(v <=> all));
+    REQUIRE(std::hash<ConcatPtrVecView<int>>()(v) == std::hash<OwnPtrVec<int>>()(all));
+
+    *all[170] = -1;
+    REQUIRE(v != all);
+    REQUIRE(v > all);
+    REQUIRE(all < v);
+    REQUIRE(v != ConcatPtrVecView<int> {a.view()});
+    REQUIRE(ConcatPtrVecView<int> {a.view()} < v);
+
+    STATIC_REQUIRE(!std::equality_comparable_with<ConcatPtrVecView<int>, OwnPtrVec<long>>);
+}
+
+TEST_CASE("ConcatPtrVecView: visitation", "[utils][ConcatPtrVecView]") {
+    struct Base {
+        virtual ~Base() = default;
+        virtual int value() const = 0;
+    };
+
+    struct One final : public Base {
+        int value() const override {
+            return 1;
+        }
+    };
+
+    struct Two final : public Base {
+        int value() const override {
+            return 2;
+        }
+    };
+
+    OwnPtrVec<Base> a, b;
+    for (int i = 0; i < 300; ++i) {
+        a.push_back(One());
+        b.push_back(Two());
+    }
+    a.push_back(Two());
+
+    ConcatPtrVecView<Base> v {a.view(), b.view()};
+    int ones = 0, twos = 0, others = 0;
+    v.for_each_as<One>([&]<typename D>(D const &d) {
+        if constexpr (std::is_same_v<D, One>)
+            ones += d.value();
+        else
+            (d.value() == 2 ? twos : others) += 1;
+    });
+    REQUIRE(ones == 300);
+    REQUIRE(twos == 301);
+    REQUIRE(others == 0);
+
+    int sum = 0;
+    v.for_each_prefetched([&](Base const &x) { sum += x.value(); }, 4);
+    REQUIRE(sum == 300 + 2 * 301);
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/concurrentptrvec.hpp>
+
+using namespace ut;
+
+namespace {
+struct Base {
+    int value;
+
+    Base(int v)
+            : value(v) { }
+
+    virtual ~Base() = default;
+};
+
+struct Counted : public Base {
+    int *dtors;
+
+    Counted(int v, int *d)
+            : Base(v)
+            , dtors(d) { }
+
+    ~Counted() override {
+        ++*dtors;
+    }
+};
+}  // namespace
+
+TEST_CASE("ConcurrentPtrVec: single thread", "[utils][ConcurrentPtrVec]") {
+    ConcurrentPtrVec<Base> v;
+    REQUIRE(v.empty());
+
+    int dtors = 0;
+    for (int i = 0; i < 1000; ++i) {
+        std::size_t idx;
+        if (i % 3 == 0)
+            idx = v.push_back(Base(i));
+        else if (i % 3 == 1)
+            idx = v.emplace_back<Counted>(i, &dtors);
+        else
+            idx = v.push_back(std::make_unique<Base>(i));
+        REQUIRE(idx == std::size_t(i));
+    }
+    REQUIRE(v.size() == 1000);
+
+    auto *first = v[0];
+    for (std::size_t i = 0; i < v.size(); ++i)
+        REQUIRE(v[i]->value == int(i));
+
+    auto snap = v.snapshot();
+    for (int i = 0; i < 100; ++i)
+        v.push_back(Base(1000 + i));
+    REQUIRE(v[0] == first);
+    REQUIRE(snap.size() == 1000);
+    REQUIRE(v.size() == 1100);
+
+    REQUIRE(std::is_sorted(snap.begin(), snap.end(), [](auto *a, auto *b) { return a->value < b->value; }));
+    REQUIRE(snap.end() - snap.begin() == 1000);
+    REQUIRE(snap.begin()[999]->value == 999);
+
+    int sum = 0;
+    snap.for_each([&](Base const &b) { sum += b.value; });
+    REQUIRE(sum == 999 * 1000 / 2);
+
+    v.clear();
+    REQUIRE(v.empty());
+    REQUIRE(dtors == 333);
+    v.push_back(Base(7));
+    REQUIRE(v[0]->value == 7);
+}
+
+TEST_CASE("ConcurrentPtrVec: concurrent producers", "[utils][ConcurrentPtrVec]") {
+    constexpr int threads = 8;
+    constexpr int per_thread = 5000;
+
+    ConcurrentPtrVec<Base> v;
+    std::atomic<bool> done = false;
+    bool prefix_ok = true;
+
+    // Every snapshot a reader takes has to be fully stored
+    std::thread reader([&] {
+        while (!done.load()) {
+            std::size_t count = 0;
+            v.snapshot().for_each([&](Base const &b) {
+                if (b.value < 0) prefix_ok = false;
+                ++count;
+            });
+            if (count > v.size()) prefix_ok = false;
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&v, t] {
+            for (int i = 0; i < per_thread; ++i)
+                v.push_back(Base(t * per_thread + i));
+        });
+    }
+    for (auto &p : producers)
+        p.join();
+    done = true;
+    reader.join();
+
+    REQUIRE(prefix_ok);
+    REQUIRE(v.size() == threads * per_thread);
+
+    std::vector<int> values;
+    for (auto *b : v.snapshot())
+        values.push_back(b->value);
+    std::sort(values.begin(), values.end());
+    for (std::size_t i = 0; i < values.size(); ++i)
+        REQUIRE(values[i] == int(i));
+}
@@ -0,0 +1,158 @@
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/cowptr.hpp>
+
+using namespace ut;
+
+TEST_CASE("CowPtr: constructors", "[utils][CowPtr]") {
+    SECTION("default constructor") {
+        CowPtr<int> c;
+        REQUIRE(*std::as_const(c) == 0);
+        REQUIRE(c.use_count() == 1);
+    }
+
+    SECTION("value constructor") {
+        CowPtr c {37};
+        REQUIRE(*std::as_const(c) == 37);
+    }
+
+    SECTION("copy shares") {
+        CowPtr<std::string> c1 = std::string("hello");
+        auto c2 = c1;
+        REQUIRE(c1.use_count() == 2);
+        REQUIRE(std::as_const(c1).get() == std::as_const(c2).get());
+    }
+
+    SECTION("move does not share") {
+        CowPtr<std::string> c1 = std::string("hello");
+        auto c2 = std::move(c1);
+        REQUIRE(c2.use_count() == 1);
+        REQUIRE(c1.use_count() == 0);
+        REQUIRE(*std::as_const(c2) == "hello");
+    }
+}
+
+TEST_CASE("CowPtr: copy on write", "[utils][CowPtr]") {
+    CowPtr<std::string> c1 = std::string("hello");
+    auto c2 = c1;
+    auto c3 = c1;
+    REQUIRE(c1.use_count() == 3);
+
+    SECTION("const access does not copy") {
+        REQUIRE(std::as_const(c2)->size() == 5);
+        REQUIRE(*std::as_const(c3) == "hello");
+        REQUIRE(c1.use_count() == 3);
+    }
+
+    SECTION("non-const access copies") {
+        *c2 += " world";
+        REQUIRE(*std::as_const(c2) == "hello world");
+        REQUIRE(*std::as_const(c1) == "hello");
+        REQUIRE(c1.use_count() == 2);
+        REQUIRE(c2.use_count() == 1);
+
+        // Already unique, no copy
+        auto const *before = std::as_const(c2).get();
+        c2->append("!");
+        REQUIRE(std::as_const(c2).get() == before);
+    }
+
+    SECTION("assignment") {
+        CowPtr<std::string> other = std::string("other");
+        c1 = other;
+        REQUIRE(c1.use_count() == 2);
+        REQUIRE(c2.use_count() == 2);
+        c1 = std::string("value");
+        REQUIRE(c1.use_count() == 1);
+        REQUIRE(*std::as_const(c1) == "value");
+    }
+}
+
+TEST_CASE("CowPtr: inheritance", "[utils][CowPtr]") {
+    struct Base {
+        int value = 1;
+
+        virtual int kind() const {
+            return 0;
+        }
+
+        virtual ~Base() = default;
+    };
+
+    struct Derived : public Base {
+        std::string name = "derived";
+
+        int kind() const override {
+            return 1;
+        }
+    };
+
+    CowPtr<Base> b = Derived {};
+    REQUIRE(b->kind() == 1);
+
+    auto copy = b;
+    copy->value = 2;
+    REQUIRE(copy.unique());
+    // The copy made on write keeps the dynamic type
+    REQUIRE(std::as_const(copy)->kind() == 1);
+    REQUIRE(std::as_const(b)->value == 1);
+    REQUIRE(std::as_const(copy)->value == 2);
+
+    CowPtr<Derived> d = Derived {};
+    CowPtr<Base> from_derived = d;
+    REQUIRE(d.use_count() == 2);
+    REQUIRE(std::as_const(from_derived)->kind() == 1);
+
+    SECTION("move-only dynamic type") {
+        struct MoveOnly : public Base {
+            MoveOnly() = default;
+            MoveOnly(MoveOnly &&) = default;
+            MoveOnly(MoveOnly const &) = delete;
+        };
+
+        CowPtr<Base> m = MoveOnly {};
+        REQUIRE(m->value == 1);
+        auto shared = m;
+        REQUIRE_THROWS_AS(shared->value = 2, NonCopyableDynamicTypeError);
+        REQUIRE(m.use_count() == 2);
+        REQUIRE(std::as_const(shared)->value == 1);
+    }
+}
+
+TEST_CASE("CowPtr: comparison", "[utils][CowPtr]") {
+    CowPtr<int> a = 1;
+    auto b = a;
+    CowPtr<int> c = 1;
+    CowPtr<int> d = 2;
+
+    REQUIRE(a == b);
+    REQUIRE(a == c);
+    REQUIRE(a != d);
+    REQUIRE(a == 1);
+    REQUIRE(a != 2);
+}
+
+TEST_CASE("CowPtr: threads", "[utils][CowPtr]") {
+    CowPtr<std::vector<int>> shared = std::vector<int>(100, 1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([shared, t]() mutable {
+            for (int i = 0; i < 100; ++i) {
+                auto copy = shared;
+                if (i % 10 == 0) (*copy)[0] = t;
+            }
+        });
+    for (auto &t : threads)
+        t.join();
+    REQUIRE(shared.use_count() == 1);
+    REQUIRE((*std::as_const(shared))[0] == 1);
+}
@@ -0,0 +1,119 @@
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/epochptrvec.hpp>
+
+using namespace ut;
+
+namespace {
+struct Item {
+    int value;
+    int *dtors;
+
+    Item(int v, int *d = nullptr)
+            : value(v)
+            , dtors(d) { }
+
+    ~Item() {
+        if (dtors) ++*dtors;
+        value = -1;
+    }
+};
+}  // namespace
+
+TEST_CASE("EpochPtrVec: single thread", "[utils][EpochPtrVec]") {
+    int dtors = 0;
+    EpochPtrVec<Item> v;
+    REQUIRE(v.empty());
+    REQUIRE(v.read().empty());
+
+    for (int i = 0; i < 10; ++i)
+        v.emplace_back(i, &dtors);
+    REQUIRE(v.size() == 10);
+    REQUIRE(v[3]->value == 3);
+    REQUIRE(v.view().size() == 10);
+
+    SECTION("a view is unaffected by later modifications") {
+        {
+            auto guard = v.read();
+            REQUIRE(guard.size() == 10);
+
+            v.erase(2, 5);
+            v.pop_back();
+            for (int i = 0; i < 100; ++i)
+                v.emplace_back(100 + i, &dtors);
+            REQUIRE(v.size() == 106);
+            REQUIRE(v[2]->value == 5);
+
+            REQUIRE(!v.try_reclaim());
+            REQUIRE(dtors == 0);
+            for (std::size_t i = 0; i < guard.size(); ++i)
+                REQUIRE(guard[i]->value == int(i));
+
+            auto other = v.read();
+            REQUIRE(other.size() == 106);
+            REQUIRE(other[2]->value == 5);
+        }
+        v.synchronize();
+        REQUIRE(v.retired() == 0);
+        REQUIRE(dtors == 4);
+    }
+
+    SECTION("clear") {
+        v.clear();
+        REQUIRE(v.empty());
+        REQUIRE(v.read().empty());
+        REQUIRE(v.retired() > 0);
+        v.synchronize();
+        REQUIRE(dtors == 10);
+        v.push_back(Item(1));
+        REQUIRE(v.read()[0]->value == 1);
+    }
+
+    SECTION("retired objects are reclaimed without readers") {
+        for (int i = 0; i < 200; ++i) {
+            v.emplace_back(i, &dtors);
+            v.erase(0);
+        }
+        REQUIRE(v.retired() < EpochPtrVec<Item>::reclaim_threshold * 2);
+        REQUIRE(dtors > 100);
+    }
+}
+
+TEST_CASE("EpochPtrVec: concurrent readers", "[utils][EpochPtrVec]") {
+    EpochPtrVec<Item> v;
+    for (int i = 0; i < 100; ++i)
+        v.emplace_back(i);
+
+    std::atomic<bool> done = false;
+    std::atomic<bool> ok = true;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                auto guard = v.read();
+                for (auto const *item : guard)
+                    if (item->value < 0) ok = false;
+            }
+        });
+    }
+
+    for (int i = 100; i < 20'000; ++i) {
+        v.emplace_back(i);
+        if (i % 3 == 0) v.erase(std::size_t(i) % v.size());
+    }
+    done = true;
+    for (auto &r : readers)
+        r.join();
+    v.synchronize();
+
+    REQUIRE(ok);
+    REQUIRE(v.retired() == 0);
+}
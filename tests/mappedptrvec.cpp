@@ -0,0 +1,122 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/mappedptrvec.hpp>
+#include <ptr-containers/ownptrvec.hpp>
+
+using namespace ut;
+
+namespace {
+struct Record {
+    std::uint64_t id;
+    double value;
+    char name[12];
+};
+
+struct TempFile {
+    std::filesystem::path path;
+
+    explicit TempFile(char const *name)
+            : path(std::filesystem::temp_directory_path() / name) { }
+
+    ~TempFile() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+};
+}  // namespace
+
+TEST_CASE("MappedPtrVec: save and map", "[utils][MappedPtrVec]") {
+    TempFile file("ptr_containers_mappedptrvec_test.bin");
+    OwnPtrVec<Record> records;
+    for (std::uint64_t i = 0; i < 1000; ++i)
+        records.push_back(Record {i, double(i) / 2, "record"});
+    MappedPtrVec<Record>::save(file.path, records);
+
+    MappedPtrVec<Record> mapped(file.path);
+    REQUIRE(mapped.size() == records.size());
+#ifdef __linux__
+    REQUIRE(mapped.is_mapped());
+#endif
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        REQUIRE(mapped[i]->id == i);
+        REQUIRE(mapped[i]->value == records[i]->value);
+        REQUIRE(std::string(mapped[i]->name) == "record");
+        REQUIRE(std::uintptr_t(mapped[i]) % alignof(Record) == 0);
+    }
+    REQUIRE(mapped.front()->id == 0);
+    REQUIRE(mapped.back()->id == 999);
+
+    SECTION("iteration") {
+        auto it = std::find_if(mapped.begin(), mapped.end(), [](Record const *r) { return r->id == 500; });
+        REQUIRE(it - mapped.begin() == 500);
+        REQUIRE((*(it + 10))->id == 510);
+        REQUIRE(it[-1]->id == 499);
+
+        std::uint64_t sum = 0;
+        mapped.for_each([&](Record const &r) { sum += r.id; });
+        REQUIRE(sum == 999 * 1000 / 2);
+    }
+
+    SECTION("the image can be mapped several times") {
+        MappedPtrVec<Record> other(file.path);
+        REQUIRE(other.size() == mapped.size());
+        REQUIRE(other[10]->id == mapped[10]->id);
+        REQUIRE(other[10] != mapped[10]);
+    }
+
+    SECTION("move") {
+        auto moved = std::move(mapped);
+        REQUIRE(moved.size() == 1000);
+        REQUIRE(mapped.empty());
+        REQUIRE(moved[3]->id == 3);
+    }
+
+    SECTION("view of part of a vector") {
+        TempFile part_file("ptr_containers_mappedptrvec_part.bin");
+        MappedPtrVec<Record>::save(part_file.path, records.view(10, 20));
+        MappedPtrVec<Record> part(part_file.path);
+        REQUIRE(part.size() == 10);
+        REQUIRE(part[0]->id == 10);
+    }
+}
+
+TEST_CASE("MappedPtrVec: invalid images", "[utils][MappedPtrVec]") {
+    TempFile file("ptr_containers_mappedptrvec_invalid.bin");
+
+    SECTION("empty vector") {
+        MappedPtrVec<Record>::save(file.path, OwnPtrVec<Record>());
+        MappedPtrVec<Record> mapped(file.path);
+        REQUIRE(mapped.empty());
+        REQUIRE(mapped.begin() == mapped.end());
+    }
+
+    SECTION("wrong element type") {
+        MappedPtrVec<Record>::save(file.path, OwnPtrVec<Record>::make(Record {}));
+        REQUIRE_THROWS_AS(MappedPtrVec<std::uint32_t>(file.path), SerializationError);
+    }
+
+    SECTION("not an image") {
+        std::ofstream(file.path) << "definitely not an image, but long enough to hold a header";
+        REQUIRE_THROWS_AS(MappedPtrVec<Record>(file.path), SerializationError);
+    }
+
+    SECTION("truncated") {
+        MappedPtrVec<Record>::save(file.path, OwnPtrVec<Record>::make(Record {}, Record {}));
+        std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) - 8);
+        REQUIRE_THROWS_AS(MappedPtrVec<Record>(file.path), SerializationError);
+    }
+
+    SECTION("missing file") {
+        REQUIRE_THROWS_AS(MappedPtrVec<Record>(file.path / "missing"), std::system_error);
+    }
+}
@@ -1,14 +1,24 @@
 #include <catch2/catch_all.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <memory_resource>
 #include <numeric>
+#include <ranges>
 #include <stack>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #ifdef assert
 #    undef assert
 #endif
 #define assert REQUIRE
+#include <ptr-containers/malloc_allocator.hpp>
 #include <ptr-containers/ownptrvec.hpp>
 
 using namespace ut;
@@ -395,6 +405,110 @@ TEST_CASE("OwnPtrVec: comparison", "[utils][OwnPtrVec]") {
     REQUIRE_FALSE(same1 == empty1);
 }
 
+TEST_CASE("OwnPtrVec: three-way comparison", "[utils][OwnPtrVec]") {
+    auto v123 = OwnPtrVec<int>::make(1, 2, 3);
+    auto v124 = OwnPtrVec<int>::make(1, 2, 4);
+    auto v12 = OwnPtrVec<int>::make(1, 2);
+    OwnPtrVec<int> empty;
+
+    REQUIRE((v123 <=> v123) == std::strong_ordering::equal);
+    REQUIRE(v123 < v124);
+    REQUIRE(v124 > v123);
+    REQUIRE(v12 < v123);
+    REQUIRE(empty < v12);
+    REQUIRE(v123 <= v123.view());
+    REQUIRE(v124.view() >= v123);
+    REQUIRE(v123.view(0, 2) == v12);
+    REQUIRE(std::is_eq(v123.view(0, 2) <=> v12));
+
+    struct LessOnly {
+        double x;
+        bool operator<(LessOnly const &other) const {
+            return x < other.x;
+        }
+    };
+    auto a = OwnPtrVec<LessOnly>::make(LessOnly {1}, LessOnly {2});
+    auto b = OwnPtrVec<LessOnly>::make(LessOnly {1}, LessOnly {3});
+    STATIC_REQUIRE(std::is_same_v<decltype(a <=> b), std::weak_ordering>);
+    REQUIRE(a < b);
+    REQUIRE_FALSE(b < a);
+}
+
+TEST_CASE("OwnPtrVec: comparison of large containers", "[utils][OwnPtrVec]") {
+    constexpr std::size_t size = std::size_t(1) << 20;
+    OwnPtrVec<int> a, b;
+    a.reserve(size);
+    b.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        a.push_back(int(i));
+        b.push_back(int(i));
+    }
+    REQUIRE(a == b);
+    REQUIRE(a == a.view());
+    REQUIRE(equal_parallel(a, b));
+    REQUIRE(equal_parallel(a, b, 3));
+    REQUIRE(equal_parallel(a, a.view(), 1));
+
+    *b[size - 10] = -1;
+    REQUIRE(a != b);
+    REQUIRE(a > b);
+    REQUIRE(!equal_parallel(a, b));
+    REQUIRE(!equal_parallel(b, a, 3));
+
+    // Mostly the same pointers, with a few differing runs
+    std::vector<int const *> ptrs(a.begin(), a.end());
+    auto c = OwnPtrVec<int>::make(int(size / 3), -5);
+    ptrs[size / 3] = c[0];
+    auto mixed = PtrVecView<int>(ptrs.data(), ptrs.size());
+    REQUIRE(a == mixed);
+    REQUIRE(equal_parallel(a, mixed));
+    REQUIRE(std::is_eq(a <=> mixed));
+    ptrs[size / 2] = c[1];
+    REQUIRE(a != mixed);
+    REQUIRE(!equal_parallel(a, mixed));
+    REQUIRE(mixed < a);
+
+    SECTION("exceptions") {
+        struct Throwing {
+            int value;
+
+            bool operator==(Throwing const &other) const {
+                if (value < 0) throw std::runtime_error("cannot compare");
+                return value == other.value;
+            }
+        };
+
+        OwnPtrVec<Throwing> x, y;
+        for (std::size_t i = 0; i < size; ++i) {
+            x.push_back(Throwing {int(i)});
+            y.push_back(Throwing {int(i)});
+        }
+        REQUIRE(equal_parallel(x, y, 4));
+        x[size - 1]->value = -1;
+        REQUIRE_THROWS_AS(equal_parallel(x, y, 4), std::runtime_error);
+        REQUIRE_THROWS_AS(x == y, std::runtime_error);
+    }
+}
+
+TEST_CASE("OwnPtrVec: hashing", "[utils][OwnPtrVec]") {
+    auto a = OwnPtrVec<int>::make(1, 2, 3);
+    auto b = OwnPtrVec<int>::make(1, 2, 3);
+    auto c = OwnPtrVec<int>::make(3, 2, 1);
+
+    std::hash<OwnPtrVec<int>> hash;
+    REQUIRE(hash(a) == hash(b));
+    REQUIRE(hash(a) != hash(c));
+    REQUIRE(hash(a) == std::hash<PtrVecView<int>>()(b.view()));
+    REQUIRE(hash(OwnPtrVec<int>()) != hash(OwnPtrVec<int>::make(0)));
+
+    std::unordered_set<OwnPtrVec<int>> set;
+    set.insert(std::move(a));
+    REQUIRE(set.contains(b));
+    REQUIRE_FALSE(set.contains(c));
+
+    STATIC_REQUIRE_FALSE(std::is_default_constructible_v<std::hash<OwnPtrVec<std::vector<int>>>>);
+}
+
 TEST_CASE("OwnPtrVec: stdlib integration", "[utils][OwnPtrVec]") {
     OwnPtrVec<int> v;
     v.push_back(1);
@@ -588,6 +702,954 @@ TEST_CASE("OwnPtrVec: incomplete type", "[utils][OwnPtrVec]") {
     }
 }
 
+namespace {
+struct AllocStats {
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    std::size_t live_bytes = 0;
+};
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+    AllocStats *stats;
+
+    explicit CountingAllocator(AllocStats *s)
+            : stats(s) { }
+
+    template<typename U>
+    CountingAllocator(CountingAllocator<U> const &other)
+            : stats(other.stats) { }
+
+    T *allocate(std::size_t n) {
+        ++stats->allocations;
+        stats->live_bytes += n * sizeof(T);
+        return std::allocator<T> {}.allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n) {
+        ++stats->deallocations;
+        stats->live_bytes -= n * sizeof(T);
+        std::allocator<T> {}.deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(CountingAllocator<U> const &other) const {
+        return stats == other.stats;
+    }
+};
+}  // namespace
+
+TEST_CASE("OwnPtrVec: allocator", "[utils][OwnPtrVec]") {
+    struct Base {
+        int *m_dtors;
+
+        Base(int *dtors)
+                : m_dtors(dtors) { }
+
+        virtual int value() const {
+            return 0;
+        }
+
+        virtual ~Base() {
+            ++*m_dtors;
+        }
+    };
+
+    struct Derived : public Base {
+        long m_extra[4] = {1, 2, 3, 4};
+
+        Derived(int *dtors)
+                : Base(dtors) { }
+
+        int value() const override {
+            return int(m_extra[3]);
+        }
+    };
+
+    struct alignas(64) OverAligned : public Base {
+        OverAligned(int *dtors)
+                : Base(dtors) { }
+
+        int value() const override {
+            return 64;
+        }
+    };
+
+    using Vec = OwnPtrVec<Base, CountingAllocator<Base>>;
+    AllocStats stats;
+    int dtors = 0;
+
+    SECTION("every allocation goes through the allocator") {
+        {
+            Vec v {CountingAllocator<Base>(&stats)};
+            v.emplace_back(&dtors);
+            v.emplace_back<Derived>(&dtors);
+            v.push_back(OverAligned(&dtors));
+            --dtors;  // the temporary
+            v.insert(v.begin(), Derived(&dtors));
+            --dtors;  // the temporary
+            REQUIRE(v.size() == 4);
+            REQUIRE(v[0]->value() == 4);
+            REQUIRE(v[1]->value() == 0);
+            REQUIRE(v[2]->value() == 4);
+            REQUIRE(v[3]->value() == 64);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(v[3]) % 64 == 0);
+            REQUIRE(stats.allocations > 4);
+            REQUIRE(dtors == 0);
+
+            v.pop_back();
+            REQUIRE(dtors == 1);
+            v.erase(v.begin());
+            REQUIRE(dtors == 2);
+            v.clear();
+            REQUIRE(dtors == 4);
+            v.emplace_back<Derived>(&dtors);
+        }
+        REQUIRE(dtors == 5);
+        REQUIRE(stats.allocations == stats.deallocations);
+        REQUIRE(stats.live_bytes == 0);
+    }
+
+    SECTION("make and fromReserve") {
+        {
+            auto v = Vec::make(std::allocator_arg,
+                CountingAllocator<Base>(&stats),
+                Base(&dtors),
+                Derived(&dtors));
+            dtors -= 2;  // the temporaries
+            REQUIRE(v.size() == 2);
+            REQUIRE(v.capacity() == 2);
+            REQUIRE(v[1]->value() == 4);
+
+            auto r = Vec::fromReserve(10, CountingAllocator<Base>(&stats));
+            REQUIRE(r.capacity() == 10);
+            REQUIRE(r.get_allocator() == v.get_allocator());
+        }
+        REQUIRE(dtors == 2);
+        REQUIRE(stats.allocations == stats.deallocations);
+        REQUIRE(stats.live_bytes == 0);
+    }
+
+    SECTION("move") {
+        {
+            Vec v1 {CountingAllocator<Base>(&stats)};
+            v1.emplace_back<Derived>(&dtors);
+            auto const allocs = stats.allocations;
+            Vec v2 = std::move(v1);
+            REQUIRE(v1.size() == 0);
+            REQUIRE(v2.size() == 1);
+            REQUIRE(stats.allocations == allocs);
+            v1 = std::move(v2);
+            REQUIRE(v1.size() == 1);
+            REQUIRE(v1[0]->value() == 4);
+        }
+        REQUIRE(dtors == 1);
+        REQUIRE(stats.allocations == stats.deallocations);
+    }
+
+    SECTION("pmr") {
+        using PmrVec = OwnPtrVec<Base, std::pmr::polymorphic_allocator<Base>>;
+        std::byte buf1[1024];
+        std::byte buf2[1024];
+        std::pmr::monotonic_buffer_resource res1(buf1, sizeof(buf1), std::pmr::null_memory_resource());
+        std::pmr::monotonic_buffer_resource res2(buf2, sizeof(buf2), std::pmr::null_memory_resource());
+
+        {
+            PmrVec v1 {&res1};
+            v1.emplace_back(&dtors);
+            v1.emplace_back<Derived>(&dtors);
+            auto const *first = reinterpret_cast<std::byte const *>(v1[0]);
+            REQUIRE(first >= buf1);
+            REQUIRE(first < buf1 + sizeof(buf1));
+
+            // Different resources and pmr allocators do not propagate: elements have to be moved
+            PmrVec v2 {&res2};
+            v2 = std::move(v1);
+            REQUIRE(v2.size() == 2);
+            REQUIRE(v1.size() == 0);
+            REQUIRE(v2.get_allocator().resource() == &res2);
+            auto const *moved = reinterpret_cast<std::byte const *>(v2[1]);
+            REQUIRE(moved >= buf2);
+            REQUIRE(moved < buf2 + sizeof(buf2));
+            REQUIRE(v2[0]->value() == 0);
+            REQUIRE(v2[1]->value() == 4);
+            REQUIRE(dtors == 2);
+        }
+        REQUIRE(dtors == 4);
+    }
+
+    SECTION("comparison with default allocator") {
+        auto a = OwnPtrVec<int>::make(1, 2, 3);
+        auto b = OwnPtrVec<int, CountingAllocator<int>>::make(std::allocator_arg,
+            CountingAllocator<int>(&stats),
+            1,
+            2,
+            3);
+        REQUIRE(a == b);
+        b.pop_back();
+        REQUIRE(a != b);
+    }
+}
+
+TEST_CASE("OwnPtrVec: clone", "[utils][OwnPtrVec]") {
+    struct Shape {
+        virtual int area() const = 0;
+        virtual ~Shape() = default;
+    };
+
+    struct Square : public Shape {
+        int side;
+
+        Square(int s)
+                : side(s) { }
+
+        int area() const override {
+            return side * side;
+        }
+    };
+
+    struct Named : public Square {
+        std::string name;
+
+        Named(int s, std::string n)
+                : Square(s)
+                , name(std::move(n)) { }
+    };
+
+    SECTION("elements are copied with their dynamic type") {
+        ArenaPtrVec<Shape> v;
+        v.push_back(Square(2));
+        v.push_back(Named(3, std::string(100, 'x')));
+        v.emplace_back<Square>(4);
+
+        auto c = v.clone();
+        REQUIRE(c.size() == 3);
+        REQUIRE(c[0]->area() == 4);
+        REQUIRE(c[1]->area() == 9);
+        REQUIRE(c[2]->area() == 16);
+        REQUIRE(dynamic_cast<Named const *>(c[1])->name == std::string(100, 'x'));
+        for (std::size_t i = 0; i < v.size(); ++i)
+            REQUIRE(c[i] != v[i]);
+
+        // Modifying the copy does not change the original
+        dynamic_cast<Named *>(c[1])->name = "copy";
+        REQUIRE(dynamic_cast<Named const *>(v[1])->name == std::string(100, 'x'));
+    }
+
+    SECTION("elements are contiguous and in order") {
+        OwnPtrVec<Shape, std::pmr::polymorphic_allocator<Shape>> v;
+        for (int i = 0; i < 1000; ++i) {
+            if (i % 3)
+                v.push_back(Square(i));
+            else
+                v.push_back(Named(i, "n"));
+        }
+        auto c = v.clone();
+        REQUIRE(c.size() == v.size());
+        REQUIRE(c.get_allocator().arena().reserved_bytes() <= 1000 * (sizeof(Named) + 64) + 16 * 1024);
+        for (std::size_t i = 1; i < c.size(); ++i) {
+            REQUIRE(reinterpret_cast<std::uintptr_t>(c[i]) > reinterpret_cast<std::uintptr_t>(c[i - 1]));
+            REQUIRE(reinterpret_cast<std::uintptr_t>(c[i]) - reinterpret_cast<std::uintptr_t>(c[i - 1]) <= 64);
+            REQUIRE(c[i]->area() == int(i * i));
+        }
+    }
+
+    SECTION("default allocator with a non-polymorphic type") {
+        auto v = OwnPtrVec<std::string>::make(std::string("a"), std::string("b"));
+        auto c = v.clone();
+        REQUIRE(c == v);
+        REQUIRE(c[0] != v[0]);
+    }
+
+    SECTION("default allocator with a polymorphic type") {
+        OwnPtrVec<Shape> v;
+        v.push_back(Square(2));
+        v.emplace_back<Named>(3, "named");
+        auto c = v.clone();
+        REQUIRE(c.size() == 2);
+        REQUIRE(c[0]->area() == 4);
+        REQUIRE(dynamic_cast<Named const *>(c[1])->name == "named");
+    }
+
+    SECTION("default allocator with an unregistered type") {
+        struct Adopted : public Square {
+            using Square::Square;
+        };
+
+        OwnPtrVec<Shape> v;
+        v.push_back(Square(2));
+        v.push_back(std::unique_ptr<Shape>(std::make_unique<Adopted>(5)));
+        REQUIRE_THROWS_AS(v.clone(), UnknownDynamicTypeError);
+
+        register_dynamic_type<Adopted>();
+        auto c = v.clone();
+        REQUIRE(dynamic_cast<Adopted const *>(c[1])->area() == 25);
+    }
+
+    SECTION("move-only dynamic type") {
+        struct MoveOnly : public Square {
+            using Square::Square;
+            MoveOnly(MoveOnly &&) = default;
+            MoveOnly(MoveOnly const &) = delete;
+        };
+
+        OwnPtrVec<Shape> v;
+        v.push_back(Square(2));
+        v.push_back(MoveOnly(3));
+        REQUIRE_THROWS_AS(v.clone(), NonCopyableDynamicTypeError);
+
+        ArenaPtrVec<Shape> arena;
+        arena.push_back(MoveOnly(3));
+        REQUIRE_THROWS_AS(arena.clone(), NonCopyableDynamicTypeError);
+    }
+}
+
+TEST_CASE("OwnPtrVec: for_each_as", "[utils][OwnPtrVec]") {
+    struct Entity {
+        int ticks = 0;
+        virtual void update() = 0;
+        virtual ~Entity() = default;
+    };
+
+    struct Player final : public Entity {
+        void update() override {
+            ticks += 1;
+        }
+    };
+
+    struct Monster final : public Entity {
+        void update() override {
+            ticks += 10;
+        }
+    };
+
+    struct Prop : public Entity {
+        void update() override {
+            ticks += 100;
+        }
+    };
+
+    OwnPtrVec<Entity> v;
+    for (int i = 0; i < 30; ++i) {
+        if (i % 3 == 0)
+            v.push_back(Player {});
+        else if (i % 3 == 1)
+            v.push_back(Monster {});
+        else
+            v.push_back(Prop {});
+    }
+
+    SECTION("every element is visited once, with its static type if listed") {
+        std::vector<Entity *> order;
+        int players = 0;
+        int monsters = 0;
+        int others = 0;
+        v.for_each_as<Monster, Player>([&](auto &e) {
+            using E = std::remove_cvref_t<decltype(e)>;
+            if constexpr (std::is_same_v<E, Player>)
+                ++players;
+            else if constexpr (std::is_same_v<E, Monster>)
+                ++monsters;
+            else
+                ++others;
+            e.update();
+            order.push_back(&e);
+        });
+        REQUIRE(players == 10);
+        REQUIRE(monsters == 10);
+        REQUIRE(others == 10);
+        for (auto *e : v)
+            REQUIRE(e->ticks == (dynamic_cast<Player *>(e) ? 1 : dynamic_cast<Monster *>(e) ? 10 : 100));
+
+        // Batches in the order of the listed types, in index order within a batch
+        REQUIRE(order.size() == 30);
+        REQUIRE(order[0] == v[1]);
+        REQUIRE(order[1] == v[4]);
+        REQUIRE(order[10] == v[0]);
+        REQUIRE(order[20] == v[2]);
+        REQUIRE(order[29] == v[29]);
+    }
+
+    SECTION("const and views") {
+        int sum = 0;
+        std::as_const(v).for_each_as<Player>([&](auto const &e) { sum += e.ticks + 1; });
+        REQUIRE(sum == 30);
+
+        int players = 0;
+        v.view(0, 6).for_each_as<Player>([&](auto const &e) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(e)>, Player>) ++players;
+        });
+        REQUIRE(players == 2);
+    }
+
+    SECTION("empty") {
+        OwnPtrVec<Entity> empty;
+        int calls = 0;
+        empty.for_each_as<Player>([&](auto &) { ++calls; });
+        REQUIRE(calls == 0);
+    }
+
+    SECTION("more elements than one group") {
+        OwnPtrVec<Entity> big;
+        for (int i = 0; i < 1000; ++i) {
+            if (i % 7 == 0)
+                big.push_back(Player {});
+            else
+                big.push_back(Prop {});
+        }
+        std::vector<Entity *> order;
+        int players = 0;
+        big.for_each_as<Player>([&](auto &e) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(e)>, Player>) ++players;
+            order.push_back(&e);
+        });
+        REQUIRE(players == 143);
+        REQUIRE(order.size() == 1000);
+        // The second group starts with its first player
+        REQUIRE(order[256] == big[259]);
+        std::sort(order.begin(), order.end());
+        REQUIRE(std::adjacent_find(order.begin(), order.end()) == order.end());
+    }
+}
+
+TEST_CASE("OwnPtrVec: prefetching iteration", "[utils][OwnPtrVec]") {
+    OwnPtrVec<int> v;
+    for (int i = 0; i < 100; ++i)
+        v.push_back(i);
+
+    SECTION("range") {
+        int sum = 0;
+        for (auto *i : v.prefetched())
+            sum += *i;
+        REQUIRE(sum == 4950);
+
+        auto r = v.prefetched(4);
+        REQUIRE(r.size() == 100);
+        REQUIRE(std::distance(r.begin(), r.end()) == 100);
+        REQUIRE(**std::find_if(r.begin(), r.end(), [](int const *i) { return *i == 42; }) == 42);
+        REQUIRE(std::count_if(r.begin(), r.end(), [](int const *i) { return *i % 2 == 0; }) == 50);
+        REQUIRE(std::accumulate(r.begin(), r.end(), 0, [](int acc, int const *i) { return acc + *i; }) == 4950);
+        REQUIRE(r.begin()[10] == v[10]);
+        STATIC_REQUIRE(std::random_access_iterator<decltype(r.begin())>);
+    }
+
+    SECTION("mutating algorithms") {
+        auto r = v.prefetched();
+        std::reverse(r.begin(), r.end());
+        REQUIRE(*v[0] == 99);
+        std::sort(r.begin(), r.end(), [](int const *a, int const *b) { return *a < *b; });
+        REQUIRE(*v[0] == 0);
+        REQUIRE(*v[99] == 99);
+    }
+
+    SECTION("for_each_prefetched") {
+        v.for_each_prefetched([](int &i) { i *= 2; });
+        int sum = 0;
+        std::as_const(v).for_each_prefetched([&](int const &i) { sum += i; }, 3);
+        REQUIRE(sum == 9900);
+    }
+
+    SECTION("empty") {
+        OwnPtrVec<int> empty;
+        auto r = empty.prefetched();
+        REQUIRE(r.begin() == r.end());
+        empty.for_each_prefetched([](int &) { FAIL(); });
+    }
+}
+
+TEST_CASE("OwnPtrVec: bulk insertion", "[utils][OwnPtrVec]") {
+    auto v = OwnPtrVec<int>::make(1, 2, 3);
+
+    SECTION("insert range in the middle") {
+        std::vector<int> values {10, 11, 12, 13, 14};
+        auto it = v.insert(v.begin() + 1, values.begin(), values.end());
+        REQUIRE(it == v.begin() + 1);
+        REQUIRE(v.size() == 8);
+        std::vector<int> actual;
+        for (auto *i : v)
+            actual.push_back(*i);
+        REQUIRE(actual == std::vector<int> {1, 10, 11, 12, 13, 14, 2, 3});
+    }
+
+    SECTION("insert grows the capacity once") {
+        v.shrink_to_fit();
+        std::vector<int> values(100, 7);
+        v.insert(v.begin(), values.begin(), values.end());
+        REQUIRE(v.size() == 103);
+        REQUIRE(v.capacity() < 2 * 103);
+        REQUIRE(*v[99] == 7);
+        REQUIRE(*v[100] == 1);
+    }
+
+    SECTION("empty range") {
+        std::vector<int> values;
+        auto it = v.insert(v.begin() + 2, values.begin(), values.end());
+        REQUIRE(it == v.begin() + 2);
+        REQUIRE(v.size() == 3);
+    }
+
+    SECTION("append_range") {
+        v.append_range(std::vector<int> {4, 5});
+        v.append_range(std::views::iota(6, 9));
+        REQUIRE(v.size() == 8);
+        for (int i = 0; i < 8; ++i)
+            REQUIRE(*v[std::size_t(i)] == i + 1);
+    }
+
+    SECTION("move iterators") {
+        std::vector<std::string> strings {std::string(100, 'a'), std::string(100, 'b')};
+        OwnPtrVec<std::string> s;
+        s.insert(s.begin(), std::make_move_iterator(strings.begin()), std::make_move_iterator(strings.end()));
+        REQUIRE(s.size() == 2);
+        REQUIRE(*s[1] == std::string(100, 'b'));
+        REQUIRE(strings[0].empty());
+    }
+
+    SECTION("exception safety") {
+        struct Throwing {
+            int value;
+
+            Throwing(int v)
+                    : value(v) { }
+
+            Throwing(Throwing const &other)
+                    : value(other.value) {
+                if (value == 3) throw std::runtime_error("copy");
+            }
+        };
+
+        auto t = OwnPtrVec<Throwing>::make(Throwing(10), Throwing(11));
+        std::vector<Throwing> values;
+        values.reserve(3);
+        for (int i = 1; i <= 3; ++i)
+            values.emplace_back(i);
+        REQUIRE_THROWS(t.insert(t.begin() + 1, values.begin(), values.end()));
+        REQUIRE(t.size() == 2);
+        REQUIRE(t[0]->value == 10);
+        REQUIRE(t[1]->value == 11);
+    }
+
+    SECTION("splice") {
+        auto other = OwnPtrVec<int>::make(7, 8);
+        auto const *seven = other[0];
+        auto it = v.splice(v.begin() + 1, std::move(other));
+        REQUIRE(it == v.begin() + 1);
+        REQUIRE(other.empty());
+        REQUIRE(v.size() == 5);
+        REQUIRE(v[1] == seven);
+        REQUIRE(*v[2] == 8);
+        REQUIRE(*v[3] == 2);
+
+        other.push_back(9);
+        v.splice(v.end(), std::move(other));
+        REQUIRE(*v.back() == 9);
+    }
+
+    SECTION("splice with unequal allocators") {
+        using PmrVec = OwnPtrVec<int, std::pmr::polymorphic_allocator<int>>;
+        std::pmr::monotonic_buffer_resource res1;
+        std::pmr::monotonic_buffer_resource res2;
+        PmrVec a {&res1};
+        PmrVec b {&res2};
+        a.push_back(1);
+        b.push_back(2);
+        b.push_back(3);
+        a.splice(a.begin(), std::move(b));
+        REQUIRE(b.empty());
+        REQUIRE(a.size() == 3);
+        REQUIRE(*a[0] == 2);
+        REQUIRE(*a[2] == 1);
+    }
+}
+
+TEST_CASE("OwnPtrVec: growth policies", "[utils][OwnPtrVec]") {
+    SECTION("policies") {
+        STATIC_REQUIRE(GeometricGrowth<>::grow(0, 1) == 2);
+        STATIC_REQUIRE(GeometricGrowth<>::grow(2, 3) == 3);
+        STATIC_REQUIRE(GeometricGrowth<>::grow(10, 11) == 15);
+        STATIC_REQUIRE(GeometricGrowth<2, 1>::grow(10, 11) == 20);
+        STATIC_REQUIRE(GeometricGrowth<>::grow(10, 100) == 109);
+        STATIC_REQUIRE(ChunkGrowth<64>::grow(64, 65) == 128);
+        STATIC_REQUIRE(PowerOfTwoGrowth::grow(0, 1) == 2);
+        STATIC_REQUIRE(PowerOfTwoGrowth::grow(64, 65) == 128);
+    }
+
+    SECTION("vector uses the policy") {
+        OwnPtrVec<int, std::allocator<int>, ChunkGrowth<16>> chunked;
+        for (int i = 0; i < 17; ++i)
+            chunked.push_back(i);
+        REQUIRE(chunked.capacity() == 32);
+
+        OwnPtrVec<int, std::allocator<int>, PowerOfTwoGrowth> pow2;
+        for (int i = 0; i < 100; ++i)
+            pow2.push_back(i);
+        REQUIRE(pow2.capacity() == 128);
+        pow2.insert(pow2.begin() + 3, 7);
+        REQUIRE(*pow2[3] == 7);
+        REQUIRE(*pow2[4] == 3);
+
+        auto plain = OwnPtrVec<int>::make(0, 1, 2);
+        REQUIRE(plain == chunked.view(0, 3));
+    }
+
+    SECTION("stack") {
+        OwnPtrStack<int, std::allocator<int>, ChunkGrowth<8>> s;
+        s.push(1);
+        REQUIRE(*s.top() == 1);
+    }
+
+    SECTION("malloc buffer") {
+        using Vec = OwnPtrVec<int, std::allocator<int>, GeometricGrowth<>, MallocBuffer<>>;
+        Vec v;
+        for (int i = 0; i < 1000; ++i)
+            v.push_back(i);
+        v.insert(v.begin(), -1);
+        v.shrink_to_fit();
+        REQUIRE(v.capacity() == 1001);
+        REQUIRE(*v[0] == -1);
+        REQUIRE(*v[1000] == 999);
+        v.reserve(5000);
+        REQUIRE(*v[500] == 499);
+        v.clear();
+        REQUIRE(v.empty());
+    }
+
+    SECTION("malloc buffer with a region allocator") {
+        // The buffer outlives the regions the elements are released with
+        OwnPtrVec<int, ArenaAllocator<int>, GeometricGrowth<>, MallocBuffer<>> v;
+        for (int i = 0; i < 100; ++i)
+            v.push_back(i);
+        auto const *buffer = v.data();
+        v.clear();
+        REQUIRE(v.data() == buffer);
+        for (int i = 0; i < 100; ++i)
+            v.push_back(i);
+        v.erase(v.begin(), v.begin() + 50);
+        v.defragment();
+        REQUIRE(*v[0] == 50);
+        REQUIRE(*v.back() == 99);
+    }
+
+    SECTION("large buffers") {
+        // The pointer buffer crosses the mmap threshold, and is then resized with mremap
+        OwnPtrVec<char, std::allocator<char>, GeometricGrowth<>, MallocBuffer<>> v;
+        v.reserve(MallocBuffer<>::mmap_threshold / sizeof(char *) - 1);
+        for (std::size_t i = 0; i < v.capacity(); ++i)
+            v.push_back(char(i));
+        for (int i = 0; i < 3; ++i)
+            v.reserve(v.capacity() * 2);
+        REQUIRE(v.capacity() > 4 * MallocBuffer<>::mmap_threshold / sizeof(char *));
+        for (std::size_t i = 0; i < v.size(); i += 997)
+            REQUIRE(*v[i] == char(i));
+        v.shrink_to_fit();
+        REQUIRE(*v.back() == char(v.size() - 1));
+    }
+}
+
+TEST_CASE("OwnPtrVec: huge pages", "[utils][OwnPtrVec]") {
+    using Buffer = HugePageBuffer<1024 * 1024, true>;
+    using Vec = OwnPtrVec<char, std::allocator<char>, GeometricGrowth<>, Buffer>;
+
+    Vec v;
+    for (int i = 0; i < 1000; ++i)
+        v.push_back(char(i));
+    REQUIRE(v.capacity() * sizeof(char *) < Buffer::mmap_threshold);
+    // The elements still come from the default allocator
+    v.push_back(std::make_unique<char>('x'));
+    REQUIRE(*v.release_back() == 'x');
+
+    v.reserve(Buffer::mmap_threshold / sizeof(char *) + 1);
+#ifdef __linux__
+    REQUIRE(reinterpret_cast<std::uintptr_t>(v.data()) % HugePageMapping<>::huge_page_size == 0);
+#endif
+    for (std::size_t i = v.size(); i < 300'000; ++i)
+        v.push_back(char(i));
+    v.reserve(v.capacity() * 3);
+    for (std::size_t i = 0; i < v.size(); i += 1009)
+        REQUIRE(*v[i] == char(i));
+#ifdef __linux__
+    REQUIRE(reinterpret_cast<std::uintptr_t>(v.data()) % HugePageMapping<>::huge_page_size == 0);
+#endif
+    v.shrink_to_fit();
+    REQUIRE(*v.back() == char(v.size() - 1));
+}
+
+TEST_CASE("OwnPtrVec: bulk destruction", "[utils][OwnPtrVec]") {
+    struct Counted {
+        std::atomic<int> *dtors;
+
+        Counted(std::atomic<int> *d)
+                : dtors(d) { }
+
+        ~Counted() {
+            dtors->fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<int> dtors = 0;
+    OwnPtrVec<Counted> v;
+    for (int i = 0; i < 50'000; ++i)
+        v.emplace_back(&dtors);
+
+    SECTION("parallel") {
+        v.clear_parallel(4);
+        REQUIRE(v.empty());
+        REQUIRE(dtors == 50'000);
+        v.emplace_back(&dtors);
+        REQUIRE(v.size() == 1);
+    }
+
+    SECTION("parallel on few elements runs inline") {
+        v.erase(v.begin() + 10, v.end());
+        dtors = 0;
+        v.clear_parallel();
+        REQUIRE(v.empty());
+        REQUIRE(dtors == 10);
+    }
+
+    SECTION("address ordered") {
+        std::reverse(v.begin(), v.end());
+        v.clear_address_ordered();
+        REQUIRE(v.empty());
+        REQUIRE(dtors == 50'000);
+    }
+}
+
+TEST_CASE("OwnPtrVec: erase by predicate", "[utils][OwnPtrVec]") {
+    OwnPtrVec<int> v;
+    for (int i = 0; i < 1000; ++i)
+        v.push_back(i);
+
+    SECTION("retain") {
+        REQUIRE(v.retain([](int x) { return x % 3 == 0; }) == 666);
+        REQUIRE(v.size() == 334);
+        for (std::size_t i = 0; i < v.size(); ++i)
+            REQUIRE(*v[i] == int(3 * i));
+        REQUIRE(v.retain([](int const *) { return true; }) == 0);
+        REQUIRE(v.retain([](auto &) { return false; }) == 334);
+        REQUIRE(v.empty());
+    }
+
+    SECTION("erase_if") {
+        REQUIRE(erase_if(v, [](int x) { return x >= 10; }) == 990);
+        REQUIRE(v.size() == 10);
+        REQUIRE(*v.back() == 9);
+        REQUIRE(erase_if(v, [](int *p) { return *p % 2; }) == 5);
+        REQUIRE(*v[4] == 8);
+    }
+
+    SECTION("throwing predicate keeps the unvisited elements") {
+        int calls = 0;
+        REQUIRE_THROWS_AS(v.retain([&](int x) {
+            if (++calls == 500) throw std::runtime_error("");
+            return x % 2 == 0;
+        }),
+            std::runtime_error);
+        REQUIRE(v.size() == 250 + 501);
+        REQUIRE(*v[249] == 498);
+        REQUIRE(*v[250] == 499);
+        REQUIRE(*v.back() == 999);
+    }
+
+    SECTION("allocator") {
+        ArenaPtrVec<std::string> a;
+        for (int i = 0; i < 100; ++i)
+            a.push_back(std::to_string(i));
+        REQUIRE(erase_if(a, [](std::string const &s) { return s.size() == 2; }) == 90);
+        REQUIRE(a.size() == 10);
+        REQUIRE(*a.back() == "9");
+    }
+}
+
+TEST_CASE("OwnPtrVec: sorting by key", "[utils][OwnPtrVec]") {
+    struct Player {
+        std::string name;
+        long score;
+    };
+
+    auto make = [](std::size_t count) {
+        OwnPtrVec<Player> v;
+        std::uint32_t state = 12345;
+        for (std::size_t i = 0; i < count; ++i) {
+            state = state * 1664525u + 1013904223u;
+            v.push_back(Player {std::to_string(i), long(state % 2001) - 1000});
+        }
+        return v;
+    };
+
+    auto isSortedByScore = [](auto const &v, auto comp) {
+        return std::is_sorted(v.begin(), v.end(), [&](auto *a, auto *b) { return comp(a->score, b->score); });
+    };
+
+    // Equal scores keep their insertion order (the names are the indices)
+    auto isStable = [](auto const &v) {
+        for (std::size_t i = 1; i < v.size(); ++i)
+            if (v[i - 1]->score == v[i]->score && std::stoul(v[i - 1]->name) > std::stoul(v[i]->name))  //
+                return false;
+        return true;
+    };
+
+    for (std::size_t count : {0, 10, 5000}) {
+        auto v = make(count);
+        v.sort_by_key(&Player::score);
+        REQUIRE(v.size() == count);
+        REQUIRE(isSortedByScore(v, std::less<>()));
+        REQUIRE(isStable(v));
+
+        v.sort_by_key([](Player const &p) { return p.score; }, std::greater<>());
+        REQUIRE(isSortedByScore(v, std::greater<>()));
+    }
+
+    SECTION("non-integral keys") {
+        auto v = make(1000);
+        v.sort_by_key(&Player::name);
+        REQUIRE(std::is_sorted(v.begin(), v.end(), [](auto *a, auto *b) { return a->name < b->name; }));
+        auto w = make(1000);
+        w.sort_by_key([](Player const &p) { return double(p.score) / 3; });
+        REQUIRE(isSortedByScore(w, std::less<>()));
+        REQUIRE(isStable(w));
+    }
+
+    SECTION("top k") {
+        auto v = make(5000);
+        auto expected = make(5000);
+        expected.sort_by_key(&Player::score, std::greater<>());
+
+        v.partial_sort_by_key(10, &Player::score, std::greater<>());
+        REQUIRE(v.size() == 5000);
+        for (std::size_t i = 0; i < 10; ++i)
+            REQUIRE(v[i]->score == expected[i]->score);
+        REQUIRE(isStable(v.view(10)));
+        auto w = make(5000);
+        w.partial_sort_by_key(5000, &Player::score);
+        REQUIRE(isSortedByScore(w, std::less<>()));
+
+        v.nth_element_by_key(2500, &Player::score);
+        auto const median = v[2500]->score;
+        for (std::size_t i = 0; i < v.size(); ++i)
+            REQUIRE((i < 2500 ? v[i]->score <= median : v[i]->score >= median));
+    }
+}
+
+TEST_CASE("OwnPtrVec: type filtered views", "[utils][OwnPtrVec]") {
+    struct Component {
+        virtual ~Component() = default;
+    };
+
+    struct Mesh : public Component {
+        int vertices;
+
+        Mesh(int v)
+                : vertices(v) { }
+    };
+
+    struct SkinnedMesh : public Mesh {
+        using Mesh::Mesh;
+    };
+
+    struct Light : public Component { };
+
+    OwnPtrVec<Component> v;
+    for (int i = 0; i < 30; ++i) {
+        if (i % 3 == 0)
+            v.push_back(Mesh(i));
+        else if (i % 3 == 1)
+            v.push_back(Light());
+        else
+            v.push_back(SkinnedMesh(i));
+    }
+
+    auto meshes = v.view_of<Mesh>();
+    REQUIRE(meshes.size() == 20);
+    int sum = 0;
+    for (Mesh *m : meshes)
+        sum += m->vertices;
+    REQUIRE(sum == 30 * 29 / 2 - (1 + 28) * 10 / 2);
+    REQUIRE(meshes.index(1) == 2);
+    REQUIRE(meshes[1] == v[2]);
+
+    REQUIRE(v.view_of<SkinnedMesh>().size() == 10);
+    REQUIRE(v.view_of<Light>().size() == 10);
+    REQUIRE(std::as_const(v).view_of<Mesh>().size() == 20);
+
+    SECTION("the indices are cached until the vector changes") {
+        REQUIRE(v.view_of<Mesh>().begin() == meshes.begin());
+        v.push_back(Mesh(100));
+        auto updated = v.view_of<Mesh>();
+        REQUIRE(updated.size() == 21);
+        REQUIRE((*(updated.end() - 1))->vertices == 100);
+
+        v.erase(v.begin(), v.begin() + 3);
+        REQUIRE(v.view_of<Mesh>().size() == 19);
+        v.retain([](Component &c) { return !dynamic_cast<SkinnedMesh *>(&c); });
+        REQUIRE(v.view_of<Mesh>().size() == 10);
+        REQUIRE(v.view_of<SkinnedMesh>().empty());
+        v.clear();
+        REQUIRE(v.view_of<Light>().empty());
+    }
+
+    SECTION("moving and swapping") {
+        auto other = std::move(v);
+        REQUIRE(v.view_of<Mesh>().empty());
+        REQUIRE(other.view_of<Mesh>().size() == 20);
+        v.swap(other);
+        REQUIRE(v.view_of<Light>().size() == 10);
+        REQUIRE(other.view_of<Light>().empty());
+    }
+
+    SECTION("reordering through iterators") {
+        auto byKind = [](Component const *a, Component const *b) {
+            return bool(dynamic_cast<Light const *>(a)) > bool(dynamic_cast<Light const *>(b));
+        };
+        std::stable_sort(v.begin(), v.end(), byKind);
+        auto sorted = v.view_of<Mesh>();
+        REQUIRE(sorted.size() == 20);
+        REQUIRE(sorted.index(0) == 10);
+        for (Mesh *m : sorted)
+            REQUIRE(dynamic_cast<Mesh *>(static_cast<Component *>(m)) == m);
+
+        std::swap(*v.begin(), *(v.end() - 1));
+        REQUIRE(v.view_of<Mesh>().index(0) == 0);
+        REQUIRE(dynamic_cast<Mesh *>(v[0]));
+
+        std::reverse(v.data(), v.data() + v.size());
+        REQUIRE(v.view_of<Light>().index(1) == 20);
+        REQUIRE(dynamic_cast<Light *>(v.view_of<Light>()[0]));
+    }
+
+    SECTION("const views only read the cache") {
+        auto const &cv = v;
+        REQUIRE(cv.view_of<Mesh>().begin() == cv.view_of<Mesh>().begin());
+        auto all = cv.view_of<Component>();
+        REQUIRE(all.size() == 30);
+        REQUIRE(cv.view_of<Component>().begin() != all.begin());
+        REQUIRE(v.view_of<Component>().size() == 30);
+        REQUIRE(cv.view_of<Component>().begin() == cv.view_of<Component>().begin());
+
+        // Dropped from the cache, but still alive
+        v.reserve(1000);
+        REQUIRE(meshes.index(19) == 29);
+    }
+
+    SECTION("other buffers") {
+        OwnPtrVec<Component, std::allocator<Component>, GeometricGrowth<>, MallocBuffer<>> malloced;
+        ArenaPtrVec<Component> arena;
+        for (int i = 0; i < 100; ++i) {
+            malloced.push_back(Mesh(i));
+            arena.push_back(Light());
+            REQUIRE(malloced.view_of<Mesh>().size() == std::size_t(i + 1));
+            REQUIRE(arena.view_of<Light>().size() == std::size_t(i + 1));
+        }
+        malloced.shrink_to_fit();
+        REQUIRE(malloced.view_of<Light>().empty());
+        arena.defragment();
+        REQUIRE(arena.view_of<Light>().size() == 100);
+        arena.clear();
+        REQUIRE(arena.view_of<Light>().empty());
+    }
+}
+
 TEST_CASE("OwnPtrVec: static assertions", "[utils][OwnPtrVec]") {
 
     SECTION("IsDerivedFromContainerBaseV") {
@@ -601,6 +1663,15 @@ TEST_CASE("OwnPtrVec: static assertions", "[utils][OwnPtrVec]") {
     }
 
 
+    SECTION("size") {
+        struct Polymorphic {
+            virtual ~Polymorphic() = default;
+        };
+
+        STATIC_REQUIRE(sizeof(OwnPtrVec<int>) == 3 * sizeof(void *));
+        STATIC_REQUIRE(sizeof(OwnPtrVec<Polymorphic>) == 3 * sizeof(void *));
+    }
+
     SECTION("IsComparableContainerBaseV") {
         STATIC_REQUIRE(IsComparableContainerBaseV<OwnPtrVec<int>, OwnPtrVec<int>>);
         STATIC_REQUIRE(IsComparableContainerBaseV<OwnPtrVec<struct S>, OwnPtrVec<struct S>>);
@@ -614,6 +1685,11 @@ TEST_CASE("OwnPtrVec: static assertions", "[utils][OwnPtrVec]") {
         STATIC_REQUIRE(IsComparableContainerBaseV<OwnPtrVec<struct S>, PtrVecView<struct S>>);
         STATIC_REQUIRE(!IsComparableContainerBaseV<OwnPtrVec<struct S>, PtrVecView<int>>);
 
+        using PmrIntVec = OwnPtrVec<int, std::pmr::polymorphic_allocator<int>>;
+        using PmrLongVec = OwnPtrVec<long, std::pmr::polymorphic_allocator<long>>;
+        STATIC_REQUIRE(IsComparableContainerBaseV<OwnPtrVec<int>, PmrIntVec>);
+        STATIC_REQUIRE(!IsComparableContainerBaseV<OwnPtrVec<int>, PmrLongVec>);
+
         STATIC_REQUIRE(IsComparableContainerBaseV<PtrVecView<int>, PtrVecView<int>>);
         STATIC_REQUIRE(IsComparableContainerBaseV<PtrVecView<struct S>, PtrVecView<struct S>>);
         STATIC_REQUIRE(!IsComparableContainerBaseV<PtrVecView<struct S>, PtrVecView<int>>);
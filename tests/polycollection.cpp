@@ -0,0 +1,199 @@
+#include <catch2/catch_all.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/polycollection.hpp>
+
+using namespace ut;
+
+namespace {
+struct Shape {
+    virtual int area() const = 0;
+    virtual ~Shape() = default;
+};
+
+struct Square : public Shape {
+    int side;
+
+    Square(int s)
+            : side(s) { }
+
+    int area() const override {
+        return side * side;
+    }
+};
+
+struct Rect : public Shape {
+    int w, h;
+
+    Rect(int w_, int h_)
+            : w(w_)
+            , h(h_) { }
+
+    int area() const override {
+        return w * h;
+    }
+};
+
+struct Named : public Shape {
+    std::string name;
+    int *dtors;
+
+    Named(std::string n, int *d)
+            : name(std::move(n))
+            , dtors(d) { }
+
+    Named(Named &&other) noexcept
+            : name(std::move(other.name))
+            , dtors(std::exchange(other.dtors, nullptr)) { }
+
+    ~Named() override {
+        if (dtors) ++*dtors;
+    }
+
+    int area() const override {
+        return int(name.size());
+    }
+};
+}  // namespace
+
+TEST_CASE("PolyCollection: insertion", "[utils][PolyCollection]") {
+    PolyCollection<Shape> c;
+    REQUIRE(c.empty());
+
+    for (int i = 0; i < 100; ++i) {
+        if (i % 2)
+            c.push_back(Square(i));
+        else
+            c.emplace_back<Rect>(i, 2);
+    }
+
+    REQUIRE(c.size() == 100);
+    REQUIRE(c.segment_count() == 2);
+
+    SECTION("index keeps insertion order") {
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(c[std::size_t(i)]->area() == (i % 2 ? i * i : i * 2));
+        REQUIRE(c.front()->area() == 0);
+        REQUIRE(c.back()->area() == 99 * 99);
+    }
+
+    SECTION("segments are contiguous") {
+        auto squares = c.segment<Square>();
+        auto rects = c.segment<Rect>();
+        REQUIRE(squares.size() == 50);
+        REQUIRE(rects.size() == 50);
+        REQUIRE(c.segment<Named>().empty());
+        for (std::size_t i = 0; i < squares.size(); ++i)
+            REQUIRE(squares[i].side == int(2 * i + 1));
+        REQUIRE(static_cast<Shape *>(&squares[1]) == c[3]);
+    }
+
+    SECTION("for_each") {
+        int total = 0;
+        c.for_each([&](Shape const &s) { total += s.area(); });
+
+        int typed = 0;
+        int squares = 0;
+        c.for_each<Square>([&](auto &s) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(s)>, Square>) ++squares;
+            typed += s.area();
+        });
+        REQUIRE(squares == 50);
+        REQUIRE(typed == total);
+
+        int const_total = 0;
+        std::as_const(c).for_each([&](Shape const &s) { const_total += s.area(); });
+        REQUIRE(const_total == total);
+    }
+
+    SECTION("iteration and views") {
+        int count = 0;
+        for (auto *s : c) {
+            REQUIRE(s->area() >= 0);
+            ++count;
+        }
+        REQUIRE(count == 100);
+        auto v = c.view();
+        REQUIRE(v.size() == 100);
+        REQUIRE(v[7] == c[7]);
+    }
+}
+
+TEST_CASE("PolyCollection: erase", "[utils][PolyCollection]") {
+    PolyCollection<Shape> c;
+    int dtors = 0;
+    for (int i = 0; i < 10; ++i) {
+        c.push_back(Square(i));
+        c.emplace_back<Named>(std::string(std::size_t(i), 'x'), &dtors);
+    }
+    REQUIRE(c.size() == 20);
+
+    SECTION("pop_back") {
+        c.pop_back();
+        REQUIRE(dtors == 1);
+        REQUIRE(c.size() == 19);
+        REQUIRE(c.back()->area() == 81);
+        REQUIRE(c.segment<Named>().size() == 9);
+    }
+
+    SECTION("erase from the middle keeps the order of the rest") {
+        c.erase(c.begin() + 2, c.begin() + 6);
+        REQUIRE(dtors == 2);
+        REQUIRE(c.size() == 16);
+        std::vector<int> actual;
+        for (auto *s : c)
+            actual.push_back(s->area());
+        REQUIRE(actual.size() == 16);
+        REQUIRE(actual[0] == 0);
+        REQUIRE(actual[1] == 0);
+        REQUIRE(actual[2] == 9);
+        REQUIRE(actual[3] == 3);
+        REQUIRE(actual[4] == 16);
+
+        c.push_back(Square(20));
+        REQUIRE(c.back()->area() == 400);
+        c.erase(c.begin());
+        REQUIRE(c.front()->area() == 0);
+        REQUIRE(c[2]->area() == 3);
+    }
+
+    SECTION("clear destroys all objects") {
+        c.clear();
+        REQUIRE(c.empty());
+        REQUIRE(dtors == 10);
+        c.emplace_back<Named>("a", &dtors);
+        REQUIRE(c[0]->area() == 1);
+    }
+
+    SECTION("destructor") {
+        {
+            auto moved = std::move(c);
+            REQUIRE(moved.size() == 20);
+            REQUIRE(c.empty());
+        }
+        REQUIRE(dtors == 10);
+    }
+}
+
+TEST_CASE("PolyCollection: segment growth", "[utils][PolyCollection]") {
+    PolyCollection<Shape> c;
+    c.segment_reserve<Square>(10);
+    c.push_back(Square(1));
+    auto const *first = c[0];
+    for (int i = 2; i <= 10; ++i)
+        c.push_back(Square(i));
+    REQUIRE(c[0] == first);
+
+    for (int i = 11; i <= 1000; ++i)
+        c.push_back(Square(i));
+    for (std::size_t i = 0; i < c.size(); ++i)
+        REQUIRE(c[i]->area() == int((i + 1) * (i + 1)));
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/ptrslotmap.hpp>
+
+using namespace ut;
+
+namespace {
+struct Entity {
+    int id;
+
+    Entity(int i)
+            : id(i) { }
+
+    virtual ~Entity() = default;
+};
+
+struct Player : public Entity {
+    int *dtors;
+
+    Player(int i, int *d)
+            : Entity(i)
+            , dtors(d) { }
+
+    ~Player() override {
+        ++*dtors;
+    }
+};
+}  // namespace
+
+TEST_CASE("PtrSlotMap: handles", "[utils][PtrSlotMap]") {
+    PtrSlotMap<Entity> m;
+    REQUIRE(m.empty());
+    REQUIRE(!m.contains(SlotHandle()));
+    REQUIRE(m.get(SlotHandle()) == nullptr);
+
+    int dtors = 0;
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 100; ++i) {
+        if (i % 2)
+            handles.push_back(m.emplace<Player>(i, &dtors));
+        else
+            handles.push_back(m.insert(Entity(i)));
+    }
+    handles.push_back(m.insert(std::make_unique<Entity>(100)));
+    REQUIRE(m.size() == 101);
+    for (int i = 0; i <= 100; ++i)
+        REQUIRE(m.get(handles[std::size_t(i)])->id == i);
+
+    SECTION("erase keeps other handles valid") {
+        REQUIRE(m.erase(handles[10]));
+        REQUIRE(m.erase(handles[11]));
+        REQUIRE(!m.erase(handles[11]));
+        REQUIRE(dtors == 1);
+        REQUIRE(m.size() == 99);
+        REQUIRE(!m.contains(handles[10]));
+        REQUIRE(m.get(handles[11]) == nullptr);
+        for (int i = 0; i <= 100; ++i)
+            if (i != 10 && i != 11) REQUIRE(m.get(handles[std::size_t(i)])->id == i);
+    }
+
+    SECTION("reused slots don't revive stale handles") {
+        m.erase(handles[5]);
+        auto fresh = m.insert(Entity(500));
+        REQUIRE(fresh.index == handles[5].index);
+        REQUIRE(fresh != handles[5]);
+        REQUIRE(m.get(handles[5]) == nullptr);
+        REQUIRE(m.get(fresh)->id == 500);
+    }
+
+    SECTION("dense iteration") {
+        std::vector<int> ids;
+        for (auto *e : m)
+            ids.push_back(e->id);
+        std::sort(ids.begin(), ids.end());
+        for (int i = 0; i <= 100; ++i)
+            REQUIRE(ids[std::size_t(i)] == i);
+
+        for (std::size_t i = 0; i < m.size(); ++i)
+            REQUIRE(m.get(m.handle_of(i)) == m[i]);
+        REQUIRE(m.view().size() == m.size());
+    }
+
+    SECTION("erasing while iterating") {
+        for (auto it = m.begin(); it != m.end();) {
+            if ((*it)->id % 3 == 0)
+                it = m.erase(it);
+            else
+                ++it;
+        }
+        REQUIRE(m.size() == 67);
+        for (auto *e : m)
+            REQUIRE(e->id % 3 != 0);
+        for (int i = 0; i <= 100; ++i)
+            REQUIRE(m.contains(handles[std::size_t(i)]) == (i % 3 != 0));
+    }
+
+    SECTION("release") {
+        auto ptr = m.release(handles[7]);
+        REQUIRE(ptr->id == 7);
+        REQUIRE(!m.contains(handles[7]));
+        REQUIRE(m.release(handles[7]) == nullptr);
+        ptr.reset();
+        REQUIRE(dtors == 1);
+    }
+
+    SECTION("clear and move") {
+        auto moved = std::move(m);
+        REQUIRE(m.empty());
+        REQUIRE(moved.get(handles[3])->id == 3);
+        moved.clear();
+        REQUIRE(dtors == 50);
+        REQUIRE(!moved.contains(handles[3]));
+        auto h = moved.insert(Entity(1));
+        REQUIRE(moved.get(h)->id == 1);
+    }
+}
@@ -331,3 +331,17 @@ TEST_CASE("PtrVecView: stdlib integration", "[utils][PtrVecView]") {
         REQUIRE(res == 40);
     }
 }
+
+TEST_CASE("PtrVecView: prefetching iteration", "[utils][PtrVecView]") {
+    auto v = OwnPtrVec<int>::make(1, 2, 3, 4, 5);
+    auto view = v.view(1, 4);
+
+    int sum = 0;
+    for (auto *i : view.prefetched(2))
+        sum += *i;
+    REQUIRE(sum == 9);
+
+    sum = 0;
+    view.for_each_prefetched([&](int const &i) { sum += i; });
+    REQUIRE(sum == 9);
+}
@@ -0,0 +1,126 @@
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/reclaimer.hpp>
+
+using namespace ut;
+
+namespace {
+struct Node {
+    std::atomic<int> *dtors;
+
+    Node(std::atomic<int> *d)
+            : dtors(d) { }
+
+    virtual ~Node() {
+        dtors->fetch_add(1);
+    }
+};
+
+struct Tree : public Node {
+    DeferredPtrVec<Node> children;
+
+    Tree(std::atomic<int> *d, Reclaimer &r)
+            : Node(d)
+            , children(DeferredAllocator<Node>(r)) { }
+};
+}  // namespace
+
+TEST_CASE("DeferredPtrVec: manual reclamation", "[utils][Reclaimer][OwnPtrVec]") {
+    Reclaimer reclaimer(Reclaimer::Mode::manual);
+    std::atomic<int> dtors = 0;
+
+    auto v = DeferredPtrVec<Node>(DeferredAllocator<Node>(reclaimer));
+    for (int i = 0; i < 10; ++i)
+        v.emplace_back(&dtors);
+
+    v.pop_back();
+    v.erase(v.begin(), v.begin() + 3);
+    REQUIRE(v.size() == 6);
+    REQUIRE(dtors == 0);
+    REQUIRE(reclaimer.pending() == 4);
+
+    v.clear();
+    REQUIRE(v.empty());
+    REQUIRE(reclaimer.pending() == 10);
+    REQUIRE(dtors == 0);
+
+    reclaimer.drain();
+    REQUIRE(dtors == 10);
+    REQUIRE(reclaimer.pending() == 0);
+
+    SECTION("subtrees are reclaimed with their parents") {
+        {
+            auto roots = DeferredPtrVec<Node>(DeferredAllocator<Node>(reclaimer));
+            auto *tree = static_cast<Tree *>(roots.emplace_back<Tree>(&dtors, reclaimer));
+            for (int i = 0; i < 5; ++i)
+                tree->children.emplace_back(&dtors);
+        }
+        REQUIRE(dtors == 10);
+        REQUIRE(reclaimer.pending() == 1);
+        reclaimer.drain();
+        REQUIRE(dtors == 16);
+    }
+
+    SECTION("retain hands over the erased elements") {
+        auto w = DeferredPtrVec<Node>(DeferredAllocator<Node>(reclaimer));
+        std::vector<Node *> kept;
+        for (int i = 0; i < 10; ++i) {
+            auto *node = w.emplace_back(&dtors);
+            if (i % 3) kept.push_back(node);
+        }
+        auto isKept = [&](Node &n) { return std::find(kept.begin(), kept.end(), &n) != kept.end(); };
+
+        REQUIRE(w.retain(isKept) == 4);
+        REQUIRE(std::equal(w.begin(), w.end(), kept.begin(), kept.end()));
+        REQUIRE(reclaimer.pending() == 4);
+        REQUIRE(dtors == 10);
+        reclaimer.drain();
+        REQUIRE(dtors == 14);
+
+        int calls = 0;
+        auto throwing = [&](Node &n) {
+            if (++calls == 4) throw std::runtime_error("stop");
+            return &n != kept[0];
+        };
+        REQUIRE_THROWS_AS(w.retain(throwing), std::runtime_error);
+        REQUIRE(w.size() == 5);
+        REQUIRE(std::equal(w.begin(), w.end(), kept.begin() + 1, kept.end()));
+        REQUIRE(reclaimer.pending() == 1);
+    }
+
+    SECTION("destruction of the reclaimer reclaims the rest") {
+        {
+            Reclaimer local(Reclaimer::Mode::manual);
+            auto w = DeferredPtrVec<Node>(DeferredAllocator<Node>(local));
+            w.emplace_back(&dtors);
+            w.emplace_back(&dtors);
+            w.clear();
+            REQUIRE(dtors == 10);
+        }
+        REQUIRE(dtors == 12);
+    }
+}
+
+TEST_CASE("DeferredPtrVec: background reclamation", "[utils][Reclaimer][OwnPtrVec]") {
+    Reclaimer reclaimer;
+    std::atomic<int> dtors = 0;
+
+    {
+        auto v = DeferredPtrVec<Node>(DeferredAllocator<Node>(reclaimer));
+        v.emplace_back(&dtors);
+        for (int i = 0; i < 1000; ++i)
+            v.emplace_back(&dtors);
+        v.erase(v.begin() + 1, v.begin() + 501);
+    }
+    reclaimer.drain();
+    REQUIRE(dtors == 1001);
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch_all.hpp>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#ifdef assert
+#    undef assert
+#endif
+#define assert REQUIRE
+#include <ptr-containers/serialization.hpp>
+
+using namespace ut;
+
+namespace {
+struct Shape {
+    virtual ~Shape() = default;
+    virtual double area() const = 0;
+};
+
+struct Square : Shape {
+    double side;
+
+    Square(double s)
+            : side(s) { }
+
+    explicit Square(BinaryReader &in)
+            : side(in.read<double>()) { }
+
+    void save(BinaryWriter &out) const {
+        out.write(side);
+    }
+
+    double area() const override {
+        return side * side;
+    }
+};
+
+struct Label : Shape {
+    std::string text;
+
+    Label(std::string t)
+            : text(std::move(t)) { }
+
+    double area() const override {
+        return 0;
+    }
+};
+
+struct Unregistered : Shape {
+    double area() const override {
+        return 1;
+    }
+};
+
+struct Point {
+    std::int32_t x, y;
+};
+}  // namespace
+
+template<>
+struct ut::Serializer<Label> {
+    static void save(BinaryWriter &out, Label const &label) {
+        out.write(std::uint32_t(label.text.size()));
+        out.write_bytes(label.text.data(), label.text.size());
+    }
+
+    static Label load(BinaryReader &in) {
+        std::string text(in.read<std::uint32_t>(), '\0');
+        in.read_bytes(text.data(), text.size());
+        return Label(std::move(text));
+    }
+};
+
+using Shapes = TypeRegistry<Shape, Square, Label>;
+
+TEST_CASE("TypeRegistry: vectors", "[utils][TypeRegistry]") {
+    OwnPtrVec<Shape> shapes;
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3 == 0)
+            shapes.push_back(Label("label " + std::to_string(i)));
+        else
+            shapes.push_back(Square(i));
+    }
+
+    std::stringstream stream;
+    BinaryWriter out(stream);
+    Shapes::save(out, shapes);
+    Shapes::save(out, OwnPtrVec<Shape>());
+
+    auto check = [&](auto const &loaded) {
+        REQUIRE(loaded.size() == shapes.size());
+        for (std::size_t i = 0; i < shapes.size(); ++i) {
+            REQUIRE(typeid(*loaded[i]) == typeid(*shapes[i]));
+            REQUIRE(loaded[i]->area() == shapes[i]->area());
+            if (auto const *label = dynamic_cast<Label const *>(loaded[i]))
+                REQUIRE(label->text == "label " + std::to_string(i));
+        }
+    };
+
+    SECTION("into an OwnPtrVec") {
+        BinaryReader in(stream);
+        check(Shapes::load_vector(in));
+        REQUIRE(Shapes::load_vector(in).empty());
+    }
+
+    SECTION("into an ArenaPtrVec") {
+        BinaryReader in(stream);
+        auto loaded = Shapes::load_vector<ArenaPtrVec<Shape>>(in);
+        check(loaded);
+        REQUIRE(loaded.get_allocator().arena().reserved_bytes() < 2 * Arena::default_chunk_size);
+    }
+
+    SECTION("malformed input") {
+        auto data = stream.str();
+        std::stringstream truncated(data.substr(0, data.size() / 2));
+        BinaryReader in(truncated);
+        REQUIRE_THROWS_AS(Shapes::load_vector(in), SerializationError);
+
+        std::stringstream garbage("not a vector at all");
+        BinaryReader in2(garbage);
+        REQUIRE_THROWS_AS(Shapes::load_vector(in2), SerializationError);
+    }
+
+    SECTION("unregistered type") {
+        shapes.push_back(Unregistered());
+        REQUIRE_THROWS_AS(Shapes::save(out, shapes), SerializationError);
+    }
+}
+
+TEST_CASE("TypeRegistry: ValuePtr", "[utils][TypeRegistry]") {
+    std::stringstream stream;
+    BinaryWriter out(stream);
+    ValuePtr<Shape> moved_from = Square(3);
+    ValuePtr<Shape> square = std::move(moved_from);
+    ValuePtr<Shape, 64> label = Label("text");
+    Shapes::save(out, square);
+    Shapes::save(out, label);
+    Shapes::save(out, moved_from);
+
+    BinaryReader in(stream);
+    auto a = Shapes::load_value(in);
+    REQUIRE(a->area() == 9);
+    auto b = Shapes::load_value<ValuePtr<Shape, 64>>(in);
+    REQUIRE(dynamic_cast<Label const &>(*b).text == "text");
+    REQUIRE(b.is_inline());
+    auto c = Shapes::load_value(in);
+    REQUIRE(c.get() == nullptr);
+
+    // Copies keep the dynamic type
+    ValuePtr<Shape> copy = a;
+    REQUIRE(typeid(*copy) == typeid(Square));
+}
+
+TEST_CASE("TypeRegistry: trivially copyable types", "[utils][TypeRegistry]") {
+    auto points = OwnPtrVec<Point>::make(Point {1, 2}, Point {3, 4});
+    std::stringstream stream;
+    BinaryWriter out(stream);
+    TypeRegistry<Point, Point>::save(out, points);
+
+    BinaryReader in(stream);
+    auto loaded = TypeRegistry<Point, Point>::load_vector(in);
+    REQUIRE(loaded.size() == 2);
+    REQUIRE(loaded[1]->x == 3);
+    REQUIRE(loaded[1]->y == 4);
+}
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <unordered_set>
 
 #ifdef assert
 #    undef assert
@@ -305,3 +306,324 @@ TEST_CASE("ValuePtr: inheritance", "[utils][ValuePtr]") {
         REQUIRE(v->isBase());
     }
 }
+
+TEST_CASE("ValuePtr: inline storage", "[utils][ValuePtr]") {
+    struct Shape {
+        virtual int area() const {
+            return 0;
+        }
+
+        virtual ~Shape() = default;
+    };
+
+    struct Square : public Shape {
+        int side;
+
+        Square(int s)
+                : side(s) { }
+
+        int area() const override {
+            return side * side;
+        }
+    };
+
+    struct Big : public Shape {
+        int values[64] = {};
+
+        Big(int v) {
+            values[63] = v;
+        }
+
+        int area() const override {
+            return values[63];
+        }
+    };
+
+    using InlineShape = ValuePtr<Shape, 48>;
+
+    SECTION("small objects are stored inline") {
+        InlineShape s = Square(3);
+        REQUIRE(s.is_inline());
+        REQUIRE(s->area() == 9);
+        auto const *addr = reinterpret_cast<std::byte const *>(s.get());
+        REQUIRE(addr >= reinterpret_cast<std::byte const *>(&s));
+        REQUIRE(addr < reinterpret_cast<std::byte const *>(&s) + sizeof(s));
+    }
+
+    SECTION("large objects are stored on the heap") {
+        InlineShape b = Big(7);
+        REQUIRE_FALSE(b.is_inline());
+        REQUIRE(b->area() == 7);
+    }
+
+    SECTION("no inline storage by default") {
+        ValuePtr<int> v = 3;
+        REQUIRE_FALSE(v.is_inline());
+        ValuePtr<int, sizeof(int)> i = 3;
+        REQUIRE(i.is_inline());
+        REQUIRE(*i == 3);
+    }
+
+    SECTION("copy") {
+        InlineShape s1 = Square(3);
+        InlineShape s2 = s1;
+        REQUIRE(s2.is_inline());
+        REQUIRE(s2->area() == 9);
+        REQUIRE(s1.get() != s2.get());
+
+        ValuePtr<Shape, 8> small = s1;
+        REQUIRE(small.is_inline() == (sizeof(Square) <= 8));
+        REQUIRE(small->area() == 9);
+
+        ValuePtr<Shape> heap = s1;
+        REQUIRE_FALSE(heap.is_inline());
+        REQUIRE(heap->area() == 9);
+
+        s2 = InlineShape(Square(4));
+        s1 = s2;
+        REQUIRE(s1->area() == 16);
+    }
+
+    SECTION("move") {
+        InlineShape s1 = Square(3);
+        InlineShape s2 = std::move(s1);
+        REQUIRE(s2.is_inline());
+        REQUIRE(s2->area() == 9);
+
+        InlineShape b1 = Big(5);
+        auto const *heap_obj = b1.get();
+        InlineShape b2 = std::move(b1);
+        REQUIRE(b2.get() == heap_obj);
+
+        ValuePtr<Shape> heap = std::move(s2);
+        REQUIRE_FALSE(heap.is_inline());
+        REQUIRE(heap->area() == 9);
+
+        ValuePtr<Square, 16> sq = Square(6);
+        InlineShape from_derived = std::move(sq);
+        REQUIRE(from_derived.is_inline());
+        REQUIRE(from_derived->area() == 36);
+    }
+
+    SECTION("assignment replaces the stored type") {
+        InlineShape s = Square(2);
+        s = Big(11);
+        REQUIRE_FALSE(s.is_inline());
+        REQUIRE(s->area() == 11);
+        s = Square(5);
+        REQUIRE(s.is_inline());
+        REQUIRE(s->area() == 25);
+    }
+
+    SECTION("release") {
+        InlineShape s = Square(3);
+        std::unique_ptr<Shape> ptr = s.release();
+        REQUIRE(ptr->area() == 9);
+        SUCCEED("no leak and no double delete");
+    }
+
+    SECTION("swap") {
+        InlineShape s = Square(3);
+        InlineShape b = Big(4);
+        s.swap(b);
+        REQUIRE(s->area() == 4);
+        REQUIRE(b->area() == 9);
+        REQUIRE(b.is_inline());
+        std::swap(s, b);
+        REQUIRE(s->area() == 9);
+        REQUIRE(b->area() == 4);
+    }
+
+    SECTION("destruction") {
+        struct Counted {
+            int *m_dtors;
+
+            Counted(int *dtors)
+                    : m_dtors(dtors) { }
+
+            Counted(Counted &&other) noexcept
+                    : m_dtors(other.m_dtors) { }
+
+            ~Counted() {
+                ++*m_dtors;
+            }
+        };
+
+        int dtors = 0;
+        {
+            ValuePtr<Counted, 16> c = Counted(&dtors);
+            REQUIRE(c.is_inline());
+            dtors = 0;  // the temporary
+        }
+        REQUIRE(dtors == 1);
+    }
+}
+
+TEST_CASE("ValuePtr: polymorphic copy", "[utils][ValuePtr]") {
+    struct Shape {
+        virtual int area() const = 0;
+        virtual ~Shape() = default;
+    };
+
+    struct Rect : public Shape {
+        int w, h;
+
+        Rect(int w_, int h_)
+                : w(w_)
+                , h(h_) { }
+
+        int area() const override {
+            return w * h;
+        }
+    };
+
+    SECTION("heap copies keep the dynamic type") {
+        ValuePtr<Shape> a = Rect(2, 3);
+        ValuePtr<Shape> b = a;
+        REQUIRE(b->area() == 6);
+        REQUIRE(a.get() != b.get());
+        REQUIRE(dynamic_cast<Rect const *>(b.get()) != nullptr);
+    }
+
+    SECTION("heap objects are copied inline if they fit") {
+        ValuePtr<Shape> heap = Rect(4, 5);
+        ValuePtr<Shape, 32> small = heap;
+        REQUIRE(small.is_inline());
+        REQUIRE(small->area() == 20);
+    }
+
+    SECTION("unique_ptr of the exact type") {
+        ValuePtr<Shape> a {std::make_unique<Rect>(1, 7)};
+        auto b = a;
+        REQUIRE(b->area() == 7);
+    }
+
+    SECTION("unique_ptr of an unknown type") {
+        struct Hidden : public Rect {
+            using Rect::Rect;
+        };
+
+        ValuePtr<Shape> a {std::unique_ptr<Shape>(std::make_unique<Hidden>(2, 2))};
+        REQUIRE_THROWS_AS(ValuePtr<Shape>(a), UnknownDynamicTypeError);
+
+        register_dynamic_type<Hidden>();
+        ValuePtr<Shape> b = a;
+        REQUIRE(dynamic_cast<Hidden const *>(b.get()) != nullptr);
+    }
+
+    SECTION("move-only dynamic type") {
+        struct MoveOnly : public Rect {
+            using Rect::Rect;
+            MoveOnly(MoveOnly &&) = default;
+            MoveOnly(MoveOnly const &) = delete;
+        };
+
+        ValuePtr<Shape> a {MoveOnly(2, 3)};
+        REQUIRE_THROWS_AS(ValuePtr<Shape>(a), NonCopyableDynamicTypeError);
+        ValuePtr<Shape> b {Rect(1, 1)};
+        REQUIRE_THROWS_AS(b = a, NonCopyableDynamicTypeError);
+        REQUIRE(b.get() == nullptr);
+
+        ValuePtr<Shape, 32> inline_a {MoveOnly(2, 3)};
+        REQUIRE(inline_a.is_inline());
+        REQUIRE_THROWS_AS((ValuePtr<Shape, 32>(inline_a)), NonCopyableDynamicTypeError);
+        REQUIRE(a->area() == 6);
+    }
+}
+
+namespace {
+struct Hashed {
+    int value;
+    static inline int hashes = 0;
+
+    virtual ~Hashed() = default;
+
+    Hashed(int v)
+            : value(v) { }
+
+    virtual std::size_t hash() const {
+        ++hashes;
+        return std::hash<int>()(value);
+    }
+
+    bool operator==(Hashed const &other) const {
+        return value == other.value;
+    }
+};
+
+struct HashedDerived : Hashed {
+    int extra;
+
+    HashedDerived(int v, int e)
+            : Hashed(v)
+            , extra(e) { }
+
+    std::size_t hash() const override {
+        return Hashed::hash() ^ std::hash<int>()(extra);
+    }
+};
+}  // namespace
+
+template<>
+struct std::hash<Hashed> {
+    std::size_t operator()(Hashed const &h) const {
+        return h.hash();
+    }
+};
+
+TEST_CASE("ValuePtr: hashing", "[utils][ValuePtr]") {
+    SECTION("hashes the object") {
+        ValuePtr<int> a = 5;
+        ValuePtr<int> b = 5;
+        REQUIRE(std::hash<ValuePtr<int>>()(a) == std::hash<int>()(5));
+        REQUIRE(std::hash<ValuePtr<int>>()(a) == std::hash<ValuePtr<int>>()(b));
+
+        std::unordered_set<ValuePtr<int>> set;
+        set.insert(a);
+        REQUIRE(set.contains(b));
+        REQUIRE_FALSE(set.contains(ValuePtr<int>(6)));
+    }
+
+    SECTION("dynamic type") {
+        ValuePtr<Hashed> base = Hashed(1);
+        ValuePtr<Hashed> derived = HashedDerived(1, 7);
+        REQUIRE(base.hash() != derived.hash());
+    }
+
+    SECTION("cached hash") {
+        Hashed::hashes = 0;
+        ValuePtr<Hashed, 0, true> v = Hashed(3);
+        auto const h = v.hash();
+        REQUIRE(v.hash() == h);
+        REQUIRE(std::hash<ValuePtr<Hashed, 0, true>>()(v) == h);
+        REQUIRE(Hashed::hashes == 1);
+
+        REQUIRE(v->value == 3);
+        REQUIRE(v.hash() == h);
+        REQUIRE(Hashed::hashes == 2);
+
+        std::as_const(v)->value;
+        REQUIRE(v.hash() == h);
+        REQUIRE(Hashed::hashes == 2);
+
+        (*v).value = 4;
+        REQUIRE(v.hash() == std::hash<int>()(4));
+        REQUIRE(Hashed::hashes == 3);
+
+        auto copy = v;
+        REQUIRE(copy.hash() == v.hash());
+        REQUIRE(Hashed::hashes == 3);
+
+        v = HashedDerived(4, 1);
+        REQUIRE(v.hash() != copy.hash());
+        REQUIRE(Hashed::hashes == 4);
+
+        ValuePtr<Hashed, 32, true> moved = std::move(copy);
+        REQUIRE(moved.hash() == std::hash<int>()(4));
+        REQUIRE(Hashed::hashes == 4);
+    }
+
+    SECTION("no cache takes no space") {
+        STATIC_REQUIRE(sizeof(ValuePtr<int>) == sizeof(int *));
+    }
+}